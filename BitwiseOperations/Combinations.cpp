@@ -0,0 +1,120 @@
+#include "Combinations.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define BMI2_TARGET
+#else
+#define BMI2_TARGET __attribute__((target("bmi2")))
+#endif
+
+namespace
+{
+    // pdep is microcoded on AMD before Zen 3, there this path is slower than the portable one
+    BMI2_TARGET void DepositCombinationsBMI2(uint64_t* Output, const uint64_t Count, uint64_t Mask, const uint64_t PositionsMask)
+    {
+        for (uint64_t Index = 0; Index < Count; ++Index)
+        {
+            Output[Index] = _pdep_u64(Mask, PositionsMask);
+            Mask = NextCombination(Mask);
+        }
+    }
+
+    void DepositCombinationsPortable(uint64_t* Output, const uint64_t Count, uint64_t Mask, const uint64_t PositionsMask)
+    {
+        for (uint64_t Index = 0; Index < Count; ++Index)
+        {
+            // i-th bit of Mask goes to the i-th lowest set bit of PositionsMask
+            uint64_t Deposited = 0;
+            uint64_t Positions = PositionsMask;
+            for (uint64_t Bits = Mask; Bits != 0 && Positions != 0; Bits >>= 1)
+            {
+                const uint64_t LowestPosition = Positions & (0 - Positions);
+                if (Bits & 1)
+                {
+                    Deposited |= LowestPosition;
+                }
+
+                Positions ^= LowestPosition;
+            }
+
+            Output[Index] = Deposited;
+            Mask = NextCombination(Mask);
+        }
+    }
+}
+
+bool HasBMI2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int CpuInfo[4];
+    __cpuidex(CpuInfo, 7, 0);
+    return (CpuInfo[1] & (1 << 8)) != 0;
+#else
+    return __builtin_cpu_supports("bmi2");
+#endif
+}
+
+void DepositCombinations(uint64_t* Output, const uint64_t Count, const uint64_t First, const uint64_t PositionsMask, const bool bAllowBMI2)
+{
+    static const bool bHasBMI2 = HasBMI2();
+
+    if (bHasBMI2 && bAllowBMI2)
+    {
+        DepositCombinationsBMI2(Output, Count, First, PositionsMask);
+    }
+    else
+    {
+        DepositCombinationsPortable(Output, Count, First, PositionsMask);
+    }
+}
+
+void GenerateCombinationsFrom(std::span<uint64_t> Result, const uint64_t FirstIndex, const uint32_t K)
+{
+    if (Result.empty())
+    {
+        return;
+    }
+
+    uint64_t Mask = UnrankCombination(FirstIndex, K);
+    Result[0] = Mask;
+    for (uint64_t Index = 1; Index < Result.size(); ++Index)
+    {
+        Mask = NextCombination(Mask);
+        Result[Index] = Mask;
+    }
+}
+
+uint64_t GenerateCombinationsParallel(std::span<uint64_t> Result, const uint32_t NumBits, const uint32_t K, const uint32_t InNumThreads)
+{
+    const uint64_t NumCombinations = CountCombinations(NumBits, K);
+    assert(Result.size() >= NumCombinations);
+
+    // hardware_concurrency() may report 0
+    const uint32_t NumThreads = std::max(InNumThreads, 1u);
+
+    std::vector<std::thread> Threads;
+    Threads.reserve(NumThreads);
+
+    // first NumCombinations % NumThreads threads take one mask more
+    const uint64_t SliceSize = NumCombinations / NumThreads;
+    const uint64_t NumLargerSlices = NumCombinations % NumThreads;
+
+    uint64_t FirstIndex = 0;
+    for (uint32_t ThreadIndex = 0; ThreadIndex < NumThreads; ++ThreadIndex)
+    {
+        const uint64_t NumMasks = SliceSize + (ThreadIndex < NumLargerSlices ? 1 : 0);
+        Threads.emplace_back(GenerateCombinationsFrom, Result.subspan(FirstIndex, NumMasks), FirstIndex, K);
+        FirstIndex += NumMasks;
+    }
+
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+
+    return NumCombinations;
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <span>
+
+#include <immintrin.h>
+
+// Enumerates 64-bit masks with exactly K bits set, in increasing order (Gosper's hack).
+// Results are written straight into caller provided span, which has to hold CountCombinations(NumBits, K) masks.
+
+constexpr uint32_t MaxCombinationBits = 64;
+
+// Binomials[n][k] = C(n, k), every value up to C(64, 32) fits in 64 bits
+inline constexpr auto Binomials = []() consteval
+{
+    std::array<std::array<uint64_t, MaxCombinationBits + 1>, MaxCombinationBits + 1> Result{};
+    for (uint32_t NumBits = 0; NumBits <= MaxCombinationBits; ++NumBits)
+    {
+        Result[NumBits][0] = 1;
+        for (uint32_t K = 1; K <= NumBits; ++K)
+        {
+            Result[NumBits][K] = Result[NumBits - 1][K - 1] + Result[NumBits - 1][K];
+        }
+    }
+
+    return Result;
+}();
+
+constexpr uint64_t CountCombinations(const uint32_t NumBits, const uint32_t K)
+{
+    assert(NumBits <= MaxCombinationBits);
+    return K <= NumBits ? Binomials[NumBits][K] : 0;
+}
+
+// Index of Mask in the increasing order of masks with the same number of set bits.
+// i-th lowest set bit at position p contributes C(p, i + 1), the number of smaller choices for the bits up to it.
+constexpr uint64_t RankCombination(uint64_t Mask)
+{
+    uint64_t Result = 0;
+    for (uint32_t BitIndex = 1; Mask != 0; ++BitIndex)
+    {
+        Result += Binomials[std::countr_zero(Mask)][BitIndex];
+        Mask &= Mask - 1;
+    }
+
+    return Result;
+}
+
+// Inverse of RankCombination, Index has to be below C(64, K).
+// Bits are placed from the highest one, each at the highest position whose binomial still fits in the remaining index.
+constexpr uint64_t UnrankCombination(uint64_t Index, const uint32_t K)
+{
+    uint64_t Result = 0;
+    uint32_t Position = MaxCombinationBits;
+    for (uint32_t BitIndex = K; BitIndex > 0; --BitIndex)
+    {
+        do
+        {
+            --Position;
+        }
+        while (Binomials[Position][BitIndex] > Index);
+
+        Result |= 1llu << Position;
+        Index -= Binomials[Position][BitIndex];
+    }
+
+    return Result;
+}
+
+template <uint32_t K>
+constexpr uint64_t FirstCombination()
+{
+    static_assert(K <= 64);
+    return K == 64 ? ~0llu : (1llu << K) - 1;
+}
+
+// Smallest mask greater than Mask with the same number of set bits. Mask can't be zero.
+constexpr uint64_t NextCombination(const uint64_t Mask)
+{
+    const uint64_t LowestBit = Mask & (0 - Mask);
+    const uint64_t Ripple = Mask + LowestBit;
+
+    // ones passed by the carry go back to the bottom, shifts are split so none of them reaches 64
+    return Ripple | (((Mask ^ Ripple) >> 2) >> std::countr_zero(Mask));
+}
+
+template <uint32_t K>
+uint64_t GenerateCombinations(std::span<uint64_t> Result, const uint32_t NumBits)
+{
+    const uint64_t NumCombinations = CountCombinations(NumBits, K);
+    assert(Result.size() >= NumCombinations);
+
+    if constexpr (K == 0)
+    {
+        Result[0] = 0;
+        return 1;
+    }
+
+    uint64_t Mask = FirstCombination<K>();
+    for (uint64_t Index = 0; Index < NumCombinations; ++Index)
+    {
+        Result[Index] = Mask;
+        Mask = NextCombination(Mask);
+    }
+
+    return NumCombinations;
+}
+
+// Same output as GenerateCombinations. Gosper's hack walks only the upper K - 1 bits,
+// the lowest bit takes every position below them, which is a straight run of stores done two masks at a time.
+template <uint32_t K>
+uint64_t GenerateCombinationsBatched(std::span<uint64_t> Result, const uint32_t NumBits)
+{
+    if constexpr (K < 2)
+    {
+        return GenerateCombinations<K>(Result, NumBits);
+    }
+    else
+    {
+        const uint64_t NumCombinations = CountCombinations(NumBits, K);
+        assert(Result.size() >= NumCombinations);
+
+        const uint64_t NumUpper = CountCombinations(NumBits - 1, K - 1);
+        uint64_t* Output = Result.data();
+
+        // upper bits are combinations of positions above 0
+        uint64_t UpperCombination = FirstCombination<K - 1>();
+        for (uint64_t UpperIndex = 0; UpperIndex < NumUpper; ++UpperIndex)
+        {
+            const uint64_t Upper = UpperCombination << 1;
+            const uint32_t NumLowPositions = std::countr_zero(Upper);
+            const __m128i UpperBits = _mm_set1_epi64x(static_cast<int64_t>(Upper));
+            __m128i LowBits = _mm_set_epi64x(2, 1);
+
+            uint32_t Position = 0;
+            for (; Position + 2 <= NumLowPositions; Position += 2)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(Output + Position), _mm_or_si128(UpperBits, LowBits));
+                LowBits = _mm_slli_epi64(LowBits, 2);
+            }
+            if (Position < NumLowPositions)
+            {
+                Output[Position] = Upper | 1llu << Position;
+            }
+
+            Output += NumLowPositions;
+            UpperCombination = NextCombination(UpperCombination);
+        }
+
+        return NumCombinations;
+    }
+}
+
+// Writes Count masks starting from First, every one scattered into set bits of PositionsMask.
+// Uses pdep when the CPU supports BMI2 and bAllowBMI2 is set, otherwise deposits bits one by one.
+void DepositCombinations(uint64_t* Output, uint64_t Count, uint64_t First, uint64_t PositionsMask, bool bAllowBMI2 = true);
+
+bool HasBMI2();
+
+// K element subsets of set bits of PositionsMask, e.g. masks which may use only some of the slots.
+template <uint32_t K>
+uint64_t GenerateCombinationsInMask(std::span<uint64_t> Result, const uint64_t PositionsMask, const bool bAllowBMI2 = true)
+{
+    const uint64_t NumCombinations = CountCombinations(std::popcount(PositionsMask), K);
+    assert(Result.size() >= NumCombinations);
+
+    if constexpr (K == 0)
+    {
+        Result[0] = 0;
+        return 1;
+    }
+
+    DepositCombinations(Result.data(), NumCombinations, FirstCombination<K>(), PositionsMask, bAllowBMI2);
+    return NumCombinations;
+}
+
+// Fills Result with consecutive masks with K bits set, starting from the one with FirstIndex rank.
+void GenerateCombinationsFrom(std::span<uint64_t> Result, uint64_t FirstIndex, uint32_t K);
+
+// Splits ranks [0, C(NumBits, K)) evenly between threads, every thread unranks its first mask
+// and writes its own slice of Result, so output is the same as GenerateCombinations for any number of threads.
+uint64_t GenerateCombinationsParallel(std::span<uint64_t> Result, uint32_t NumBits, uint32_t K, uint32_t NumThreads);
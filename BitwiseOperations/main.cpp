@@ -1,11 +1,22 @@
+#include <algorithm>
 #include <bitset>
 #include <chrono>
 #include <cstring>
 #include <iostream>
 #include <thread>
+#include <vector>
+
+#include "Combinations.h"
 
 void FindNumbers(std::vector<uint64_t>& Result, uint32_t NumBits);
 
+template <uint32_t K>
+void TestCombinations(uint32_t NumBits, uint32_t NumRepeats);
+
+void TestCombinationsInMask(uint32_t NumRepeats);
+
+void TestParallelCombinations(uint32_t NumBits, uint32_t K);
+
 int main()
 {
     const auto StartTime = std::chrono::high_resolution_clock::now();
@@ -31,6 +42,31 @@ int main()
     std::printf("Checksum: %llu (expected: 64424509410)\n", CheckSum);
     std::printf("Correct: %s\n", CheckSum == 64424509410llu ? "True" : "False");
 
+#if !NDEBUG
+    constexpr uint32_t NumRepeats = 1;
+#else
+    constexpr uint32_t NumRepeats = 5;
+#endif
+
+    std::printf("\n=======| K bit combinations |=======\n");
+    TestCombinations<2>(31, NumRepeats * 10000);
+    TestCombinations<2>(64, NumRepeats * 10000);
+    TestCombinations<4>(64, NumRepeats);
+    TestCombinations<6>(40, NumRepeats);
+#if NDEBUG
+    TestCombinations<8>(40, NumRepeats);
+#endif
+
+    std::printf("\n=======| K bit combinations in mask |=======\n");
+    TestCombinationsInMask(NumRepeats);
+
+    std::printf("\n=======| Parallel K bit combinations |=======\n");
+#if !NDEBUG
+    TestParallelCombinations(40, 6);
+#else
+    TestParallelCombinations(64, 6);
+#endif
+
     return 0;
 }
 
@@ -45,3 +81,140 @@ void FindNumbers(std::vector<uint64_t>& Result, uint32_t NumBits)
         }
     }
 }
+
+template <uint32_t K>
+void TestCombinations(const uint32_t NumBits, const uint32_t NumRepeats)
+{
+    const uint64_t NumCombinations = CountCombinations(NumBits, K);
+
+    // every position is set in the same number of masks
+    const uint64_t AllPositions = NumBits == 64 ? ~0llu : (1llu << NumBits) - 1;
+    const uint64_t ExpectedCheckSum = CountCombinations(NumBits - 1, K - 1) * AllPositions;
+
+    std::printf("K = %u, N = %u, %llu masks\n", K, NumBits, NumCombinations);
+
+    std::vector<uint64_t> Result(NumCombinations);
+
+    const auto Run = [&](const char* Name, const auto& Generate)
+    {
+        const auto StartTime = std::chrono::high_resolution_clock::now();
+        std::span<const uint64_t> Masks;
+        for (uint32_t RepeatId = 0; RepeatId < NumRepeats; ++RepeatId)
+        {
+            Masks = Generate();
+        }
+        const auto ProcessingTime = std::chrono::high_resolution_clock::now() - StartTime;
+        const double Time = std::chrono::duration_cast<std::chrono::nanoseconds>(ProcessingTime).count() * 1e-6 / NumRepeats;
+
+        uint64_t CheckSum = 0;
+        for (const uint64_t Mask : Masks)
+        {
+            CheckSum += Mask;
+        }
+
+        std::printf("%-14s %fms, %8.2f M masks/s (correct: %s)\n", Name, Time, static_cast<double>(NumCombinations) / Time * 1e-3,
+                    Masks.size() == NumCombinations && CheckSum == ExpectedCheckSum ? "True" : "False");
+    };
+
+    if constexpr (K == 2)
+    {
+        std::vector<uint64_t> Numbers;
+        Numbers.reserve(NumCombinations);
+        Run("nested loops", [&]() -> std::span<const uint64_t>
+        {
+            Numbers.clear();
+            FindNumbers(Numbers, NumBits);
+            return Numbers;
+        });
+    }
+
+    Run("gosper", [&]() -> std::span<const uint64_t>
+    {
+        return {Result.data(), GenerateCombinations<K>(Result, NumBits)};
+    });
+
+    Run("gosper batched", [&]() -> std::span<const uint64_t>
+    {
+        return {Result.data(), GenerateCombinationsBatched<K>(Result, NumBits)};
+    });
+}
+
+void TestCombinationsInMask(const uint32_t NumRepeats)
+{
+    // only every other slot is free
+    constexpr uint64_t PositionsMask = 0x5555555555555555llu;
+    constexpr uint32_t K = 6;
+    constexpr uint64_t NumCombinations = CountCombinations(std::popcount(PositionsMask), K);
+    constexpr uint64_t ExpectedCheckSum = CountCombinations(std::popcount(PositionsMask) - 1, K - 1) * PositionsMask;
+
+    std::printf("K = %u, mask = %016llx, %llu masks, BMI2: %s\n", K, PositionsMask, NumCombinations, HasBMI2() ? "True" : "False");
+
+    std::vector<uint64_t> Result(NumCombinations);
+    for (const bool bAllowBMI2 : {false, true})
+    {
+        const auto StartTime = std::chrono::high_resolution_clock::now();
+        for (uint32_t RepeatId = 0; RepeatId < NumRepeats; ++RepeatId)
+        {
+            GenerateCombinationsInMask<K>(Result, PositionsMask, bAllowBMI2);
+        }
+        const auto ProcessingTime = std::chrono::high_resolution_clock::now() - StartTime;
+        const double Time = std::chrono::duration_cast<std::chrono::nanoseconds>(ProcessingTime).count() * 1e-6 / NumRepeats;
+
+        uint64_t CheckSum = 0;
+        for (const uint64_t Mask : Result)
+        {
+            CheckSum += Mask;
+        }
+
+        std::printf("%-14s %fms, %8.2f M masks/s (correct: %s)\n", bAllowBMI2 ? "pdep" : "portable", Time,
+                    static_cast<double>(NumCombinations) / Time * 1e-3, CheckSum == ExpectedCheckSum ? "True" : "False");
+    }
+}
+
+void TestParallelCombinations(const uint32_t NumBits, const uint32_t K)
+{
+    const uint64_t NumCombinations = CountCombinations(NumBits, K);
+    const uint64_t AllPositions = NumBits == 64 ? ~0llu : (1llu << NumBits) - 1;
+    const uint64_t ExpectedCheckSum = CountCombinations(NumBits - 1, K - 1) * AllPositions;
+    const uint32_t MaxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    std::printf("K = %u, N = %u, %llu masks\n", K, NumBits, NumCombinations);
+
+    std::vector<uint64_t> Result(NumCombinations);
+
+    double SingleThreadTime = 0.;
+    for (uint32_t NumThreads = 1; ; NumThreads = std::min(NumThreads * 2, MaxThreads))
+    {
+        const auto StartTime = std::chrono::high_resolution_clock::now();
+        GenerateCombinationsParallel(Result, NumBits, K, NumThreads);
+        const auto ProcessingTime = std::chrono::high_resolution_clock::now() - StartTime;
+        const double Time = std::chrono::duration_cast<std::chrono::nanoseconds>(ProcessingTime).count() * 1e-6;
+
+        if (NumThreads == 1)
+        {
+            SingleThreadTime = Time;
+        }
+
+        uint64_t CheckSum = 0;
+        for (const uint64_t Mask : Result)
+        {
+            CheckSum += Mask;
+        }
+
+        std::printf("%3u threads: %fms (speedup: %.2fx) %8.2f M masks/s (correct: %s)\n", NumThreads, Time, SingleThreadTime / Time,
+                    static_cast<double>(NumCombinations) / Time * 1e-3, CheckSum == ExpectedCheckSum ? "True" : "False");
+
+        if (NumThreads == MaxThreads)
+        {
+            break;
+        }
+    }
+
+    // every mask has to be found at its own rank
+    bool bRanksCorrect = true;
+    for (uint64_t Index = 0; Index < NumCombinations; Index += NumCombinations / 1000 + 1)
+    {
+        bRanksCorrect &= RankCombination(Result[Index]) == Index && UnrankCombination(Index, K) == Result[Index];
+    }
+    std::printf("Rank/unrank correct: %s\n", bRanksCorrect ? "True" : "False");
+}
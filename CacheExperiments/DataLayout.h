@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+// Storage layouts generated from one field list. Every layout has the same accessors:
+// Get<FieldIndex>(Index), size() and resize(Count), so a loop written once runs on any of them.
+// AoSoA also hands out whole blocks with GetBlock<FieldIndex>(BlockIndex), loops over blocks and lanes
+// don't pay for splitting every index the way Get does.
+//
+//   using Particle = FieldList<float, float, float, float>;
+//   AoS<Particle>      x y z w | x y z w | ...            whole entity in one place
+//   SoA<Particle>      x x x ... | y y y ... | ...          one array per field
+//   AoSoA<Particle, 8> x*8 y*8 z*8 w*8 | x*8 y*8 ...        SoA blocks of 8 entities, one entity stays within a few lines
+
+template <typename... FieldTypes>
+struct FieldList
+{
+    static constexpr size_t NumFields = sizeof...(FieldTypes);
+    static constexpr size_t EntitySize = (sizeof(FieldTypes) + ...);
+};
+
+template <typename Entity>
+class AoS;
+
+template <typename... FieldTypes>
+class AoS<FieldList<FieldTypes...>>
+{
+public:
+    static constexpr const char* Name = "AoS";
+
+    template <size_t FieldIndex>
+    auto& Get(const size_t Index)
+    {
+        return std::get<FieldIndex>(Items[Index]);
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return Items.size();
+    }
+
+    void resize(const size_t Count)
+    {
+        Items.resize(Count);
+    }
+
+private:
+    std::vector<std::tuple<FieldTypes...>> Items;
+};
+
+template <typename Entity>
+class SoA;
+
+template <typename... FieldTypes>
+class SoA<FieldList<FieldTypes...>>
+{
+public:
+    static constexpr const char* Name = "SoA";
+
+    template <size_t FieldIndex>
+    auto& Get(const size_t Index)
+    {
+        return std::get<FieldIndex>(Columns)[Index];
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return std::get<0>(Columns).size();
+    }
+
+    void resize(const size_t Count)
+    {
+        std::apply([Count](auto&... Column)
+        {
+            (Column.resize(Count), ...);
+        }, Columns);
+    }
+
+private:
+    std::tuple<std::vector<FieldTypes>...> Columns;
+};
+
+template <typename Entity, uint32_t BlockWidth>
+class AoSoA;
+
+template <typename... FieldTypes, uint32_t BlockWidth>
+class AoSoA<FieldList<FieldTypes...>, BlockWidth>
+{
+    static_assert((BlockWidth & (BlockWidth - 1)) == 0, "index splits into block and lane with a shift and a mask");
+
+    struct Block
+    {
+        std::tuple<std::array<FieldTypes, BlockWidth>...> Lanes;
+    };
+
+public:
+    static constexpr const char* Name = BlockWidth == 4 ? "AoSoA 4" : BlockWidth == 8 ? "AoSoA 8" : BlockWidth == 16 ? "AoSoA 16" : "AoSoA";
+
+    static constexpr uint32_t Width = BlockWidth;
+
+    template <size_t FieldIndex>
+    auto& Get(const size_t Index)
+    {
+        return std::get<FieldIndex>(Blocks[Index / BlockWidth].Lanes)[Index % BlockWidth];
+    }
+
+    // lanes of one field, entity Index is lane Index % Width of block Index / Width
+    template <size_t FieldIndex>
+    auto& GetBlock(const size_t BlockIndex)
+    {
+        return std::get<FieldIndex>(Blocks[BlockIndex].Lanes);
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return Size;
+    }
+
+    [[nodiscard]] size_t NumBlocks() const
+    {
+        return Blocks.size();
+    }
+
+    // last block is allocated whole
+    void resize(const size_t Count)
+    {
+        Blocks.resize((Count + BlockWidth - 1) / BlockWidth);
+        Size = Count;
+    }
+
+private:
+    std::vector<Block> Blocks;
+    size_t Size = 0;
+};
@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "CacheTopology.h"
+#include "PerformanceCounter.h"
+
+// Dependent load latency probe. Every cache line of the working set points to the next one of a random cycle,
+// so each load needs the result of the previous one: out-of-order execution can't overlap them
+// and the prefetcher can't guess the next address. Time per load is the latency of the level the working set fits in.
+
+constexpr uint64_t CacheLineSize = 64;
+// working sets grow by sqrt(2), so every cache level gets a few points
+constexpr uint64_t MinWorkingSet = 4llu << 10;
+constexpr uint64_t MaxWorkingSet = 1llu << 30;
+constexpr uint64_t NumLoads = 1llu << 23;
+
+// Consecutive points within this ratio belong to the same plateau
+constexpr double PlateauTolerance = 1.3;
+
+struct alignas(CacheLineSize) CacheLine
+{
+    CacheLine* Next;
+};
+
+static_assert(sizeof(CacheLine) == CacheLineSize);
+
+struct LatencyPoint
+{
+    uint64_t WorkingSet;
+    double NanosecondsPerLoad;
+};
+
+struct LatencyPlateau
+{
+    uint64_t FirstWorkingSet;
+    uint64_t LastWorkingSet;
+    double NanosecondsPerLoad;
+    // level of the cache holding the plateau, DRAM past the last one
+    std::string Name;
+};
+
+std::string FormatBytes(const uint64_t Bytes)
+{
+    char Buffer[32];
+    if (Bytes >= 1llu << 30)
+    {
+        std::snprintf(Buffer, sizeof(Buffer), "%.1f GiB", static_cast<double>(Bytes) / static_cast<double>(1llu << 30));
+    }
+    else if (Bytes >= 1llu << 20)
+    {
+        std::snprintf(Buffer, sizeof(Buffer), "%.1f MiB", static_cast<double>(Bytes) / static_cast<double>(1llu << 20));
+    }
+    else
+    {
+        std::snprintf(Buffer, sizeof(Buffer), "%.1f KiB", static_cast<double>(Bytes) / static_cast<double>(1llu << 10));
+    }
+
+    return Buffer;
+}
+
+std::vector<uint64_t> MakeWorkingSets()
+{
+    std::vector<uint64_t> Result;
+    for (double WorkingSet = MinWorkingSet; WorkingSet <= MaxWorkingSet * 1.01; WorkingSet *= std::sqrt(2.))
+    {
+        Result.push_back(std::min<uint64_t>(std::llround(WorkingSet / CacheLineSize) * CacheLineSize, MaxWorkingSet));
+    }
+
+    return Result;
+}
+
+// Links first NumLines lines into a single random cycle (Sattolo's algorithm), so the chase visits all of them
+CacheLine* LinkRandomCycle(CacheLine* Lines, const uint64_t NumLines, std::mt19937_64& RandomGenerator)
+{
+    std::vector<uint64_t> Order(NumLines);
+    for (uint64_t LineIndex = 0; LineIndex < NumLines; ++LineIndex)
+    {
+        Order[LineIndex] = LineIndex;
+    }
+
+    for (uint64_t LineIndex = NumLines - 1; LineIndex > 0; --LineIndex)
+    {
+        std::uniform_int_distribution<uint64_t> Distribution(0, LineIndex - 1);
+        std::swap(Order[LineIndex], Order[Distribution(RandomGenerator)]);
+    }
+
+    for (uint64_t LineIndex = 0; LineIndex < NumLines; ++LineIndex)
+    {
+        Lines[Order[LineIndex]].Next = &Lines[Order[(LineIndex + 1) % NumLines]];
+    }
+
+    return &Lines[Order[0]];
+}
+
+// noinline keeps the loop from being merged with setup code, the returned pointer keeps the loads alive
+[[gnu::noinline]] CacheLine* Chase(CacheLine* Line, const uint64_t Count)
+{
+    for (uint64_t LoadIndex = 0; LoadIndex < Count; ++LoadIndex)
+    {
+        Line = Line->Next;
+    }
+
+    return Line;
+}
+
+LatencyPoint MeasureLatency(CacheLine* Lines, const uint64_t WorkingSet, std::mt19937_64& RandomGenerator)
+{
+    const uint64_t NumLines = WorkingSet / CacheLineSize;
+    CacheLine* Line = LinkRandomCycle(Lines, NumLines, RandomGenerator);
+
+    // one pass over the whole cycle pulls the working set into the caches it fits in
+    Line = Chase(Line, std::min(NumLines, NumLoads));
+
+    PerformanceCounter PerfCounter;
+    PerfCounter.Reset();
+    Line = Chase(Line, NumLoads);
+    const double Milliseconds = PerfCounter.Elapsed();
+
+    if (Line == nullptr)
+    {
+        std::printf("broken cycle\n");
+    }
+
+    return {WorkingSet, Milliseconds * 1e6 / static_cast<double>(NumLoads)};
+}
+
+// Splits the curve into runs of points within PlateauTolerance of the run's first point.
+// Runs with a single point are transitions between levels, where the working set partially fits.
+std::vector<LatencyPlateau> FindPlateaus(const std::vector<LatencyPoint>& Points)
+{
+    std::vector<LatencyPlateau> Result;
+
+    size_t RunStart = 0;
+    while (RunStart < Points.size())
+    {
+        size_t RunEnd = RunStart + 1;
+        while (RunEnd < Points.size() && Points[RunEnd].NanosecondsPerLoad <= Points[RunStart].NanosecondsPerLoad * PlateauTolerance)
+        {
+            ++RunEnd;
+        }
+
+        if (RunEnd - RunStart >= 2)
+        {
+            // median is robust against the first point of a level still being partially in the previous one
+            std::vector<double> Latencies;
+            for (size_t PointIndex = RunStart; PointIndex < RunEnd; ++PointIndex)
+            {
+                Latencies.push_back(Points[PointIndex].NanosecondsPerLoad);
+            }
+            std::nth_element(Latencies.begin(), Latencies.begin() + Latencies.size() / 2, Latencies.end());
+
+            Result.push_back({Points[RunStart].WorkingSet, Points[RunEnd - 1].WorkingSet, Latencies[Latencies.size() / 2]});
+        }
+
+        RunStart = RunEnd;
+    }
+
+    return Result;
+}
+
+// Smallest reported data cache holding the whole working set, nullptr past the last one
+const CacheLevel* FindCoveringCache(const uint64_t WorkingSet)
+{
+    const CacheLevel* Result = nullptr;
+    for (const CacheLevel& Cache : CacheTopology::GetCaches())
+    {
+        if (Cache.Type != CacheType::Instruction && Cache.Size >= WorkingSet && (Result == nullptr || Cache.Size < Result->Size))
+        {
+            Result = &Cache;
+        }
+    }
+
+    return Result;
+}
+
+// Names every plateau after the cache its largest working set fits in. Neighbouring plateaus of one cache are merged,
+// the later steps come from TLB misses once the working set spans more pages than the TLB covers,
+// so the level latency is the one of its first plateau.
+std::vector<LatencyPlateau> NamePlateaus(const std::vector<LatencyPlateau>& Plateaus)
+{
+    std::vector<LatencyPlateau> Result;
+    for (LatencyPlateau Plateau : Plateaus)
+    {
+        const CacheLevel* Cache = FindCoveringCache(Plateau.LastWorkingSet);
+        Plateau.Name = Cache != nullptr ? "L" + std::to_string(Cache->Level) : "DRAM";
+
+        if (!Result.empty() && Result.back().Name == Plateau.Name)
+        {
+            Result.back().LastWorkingSet = Plateau.LastWorkingSet;
+        }
+        else
+        {
+            Result.push_back(Plateau);
+        }
+    }
+
+    return Result;
+}
+
+int main()
+{
+    const std::vector<uint64_t> WorkingSets = MakeWorkingSets();
+    const std::unique_ptr<CacheLine[]> Lines(new CacheLine[WorkingSets.back() / CacheLineSize]);
+    std::mt19937_64 RandomGenerator;
+
+    // reported sizes to compare with the plateaus below
+    CacheTopology::Print();
+    std::printf("\npointer chasing, %llu dependent loads per working set\n", static_cast<unsigned long long>(NumLoads));
+
+    std::vector<LatencyPoint> Points;
+    for (const uint64_t WorkingSet : WorkingSets)
+    {
+        const LatencyPoint& Point = Points.emplace_back(MeasureLatency(Lines.get(), WorkingSet, RandomGenerator));
+        std::printf("%10s: %7.2f ns per load\n", FormatBytes(Point.WorkingSet).c_str(), Point.NanosecondsPerLoad);
+    }
+
+    // without reported cache sizes plateaus of TLB misses can't be told from cache levels, they are printed unnamed
+    const bool bHasCaches = CacheTopology::FindDataCache(1) != nullptr;
+    const std::vector<LatencyPlateau> Plateaus = bHasCaches ? NamePlateaus(FindPlateaus(Points)) : FindPlateaus(Points);
+    std::printf("\ndetected latency plateaus%s:\n", bHasCaches ? "" : ", no cache sizes reported to name them");
+    for (const LatencyPlateau& Plateau : Plateaus)
+    {
+        std::printf("%4s: %7.2f ns, working sets %s - %s\n", Plateau.Name.empty() ? "?" : Plateau.Name.c_str(), Plateau.NanosecondsPerLoad,
+                    FormatBytes(Plateau.FirstWorkingSet).c_str(), FormatBytes(Plateau.LastWorkingSet).c_str());
+    }
+
+    return 0;
+}
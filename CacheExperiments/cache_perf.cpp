@@ -1,9 +1,16 @@
+#include <algorithm>
 #include <chrono>
 #include <random>
 #include <cstring>
 
 #include <cstdio>
 #include <thread>
+#include <vector>
+
+#include <xmmintrin.h>
+
+#include "CacheTopology.h"
+#include "PageBuffer.h"
 
 class Stopwatch
 {
@@ -25,10 +32,40 @@ size_t RANDOM32BITADDRESS()
     return distribution(generator);
 }
 
+//! COPIES EVERY SAMPLE OF list[], FIELD a IS SUMMED SO THE LOADS CAN'T BE REMOVED.
+//! Four sums, so the add latency doesn't limit in cache reads. The copy size is a constant, a memcpy call would be timed otherwise.
 template<typename TestData>
-TestData TestMemAccess(size_t sampleCount, TestData *vector, TestData **list, size_t size, uint64_t &seqTime, uint64_t &randTime)
+float ReadSamples(size_t sampleCount, TestData **list)
 {
     TestData sample;
+    float sum0 = 0.f;
+    float sum1 = 0.f;
+    float sum2 = 0.f;
+    float sum3 = 0.f;
+    size_t i = 0;
+    for (; i + 4 <= sampleCount; i += 4)
+    {
+        memcpy(&sample, list[i], sizeof(TestData));
+        sum0 += sample.a;
+        memcpy(&sample, list[i + 1], sizeof(TestData));
+        sum1 += sample.a;
+        memcpy(&sample, list[i + 2], sizeof(TestData));
+        sum2 += sample.a;
+        memcpy(&sample, list[i + 3], sizeof(TestData));
+        sum3 += sample.a;
+    }
+    for (; i < sampleCount; ++i)
+    {
+        memcpy(&sample, list[i], sizeof(TestData));
+        sum0 += sample.a;
+    }
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
+template<typename TestData>
+float TestMemAccess(size_t sampleCount, TestData *vector, TestData **list, uint64_t &seqTime, uint64_t &randTime)
+{
+    float sum = 0.f;
     //! GENERATE RANDOM ADDRESS LIST
     for (size_t i = 0; i < sampleCount; ++i)
     {
@@ -37,10 +74,7 @@ TestData TestMemAccess(size_t sampleCount, TestData *vector, TestData **list, si
     }
     //! COUNT ACCESS TIME FOR RANDOM ADDRESS
     Stopwatch randCount;
-    for (size_t i = 0; i < sampleCount; ++i)
-    {
-        memcpy(&sample, list[i], size);
-    }
+    sum += ReadSamples(sampleCount, list);
     randTime += randCount.read();
     //! GENERATE SEQUENCE ADDRESS LIST
     for (size_t i = 0; i < sampleCount; ++i)
@@ -49,16 +83,53 @@ TestData TestMemAccess(size_t sampleCount, TestData *vector, TestData **list, si
     }
     //! COUNT ACCESS TIME FOR SEQUENCE ADDRESS
     Stopwatch seqCount;
-    for (size_t i = 0; i < sampleCount; ++i)
+    sum += ReadSamples(sampleCount, list);
+    seqTime += seqCount.read();
+    return sum;
+}
+
+//! RANDOM READS THROUGH list[], PREFETCHING THE ELEMENT distance AHEAD WITH THE GIVEN LOCALITY HINT, 0 DISTANCE DOESN'T PREFETCH.
+//! Field a of every element is summed into four sums, so the loads can't be removed and the add latency doesn't hide the prefetch.
+template<auto hint, typename TestData>
+float TestPrefetchedAccess(size_t sampleCount, TestData **list, size_t distance, uint64_t &time)
+{
+    float sum0 = 0.f;
+    float sum1 = 0.f;
+    float sum2 = 0.f;
+    float sum3 = 0.f;
+    Stopwatch count;
+    size_t i = 0;
+    if (distance > 0)
     {
-        memcpy(&sample, list[i], size);
+        for (; i + distance + 4 <= sampleCount; i += 4)
+        {
+            _mm_prefetch(reinterpret_cast<const char *>(list[i + distance]), hint);
+            _mm_prefetch(reinterpret_cast<const char *>(list[i + distance + 1]), hint);
+            _mm_prefetch(reinterpret_cast<const char *>(list[i + distance + 2]), hint);
+            _mm_prefetch(reinterpret_cast<const char *>(list[i + distance + 3]), hint);
+            sum0 += list[i]->a;
+            sum1 += list[i + 1]->a;
+            sum2 += list[i + 2]->a;
+            sum3 += list[i + 3]->a;
+        }
     }
-    seqTime += seqCount.read();
-    return sample;
+    for (; i + 4 <= sampleCount; i += 4)
+    {
+        sum0 += list[i]->a;
+        sum1 += list[i + 1]->a;
+        sum2 += list[i + 2]->a;
+        sum3 += list[i + 3]->a;
+    }
+    for (; i < sampleCount; ++i)
+    {
+        sum0 += list[i]->a;
+    }
+    time += count.read();
+    return (sum0 + sum1) + (sum2 + sum3);
 }
 
-//! Choose the L2 size for your CPU:
-#define L2_CACHE_SIZE (1 * 1024 * 1024)
+//! L2 size of the CPU, 1 MiB when it couldn't be detected
+size_t l2CacheSize = 1 * 1024 * 1024;
 
 #define TEST_COUNT 64
 
@@ -79,55 +150,262 @@ struct Data20
     float e;
 };
 
-Data16 vectorData16[L2_CACHE_SIZE * 4];
-Data16 *listData16[L2_CACHE_SIZE * 4];
-Data20 vectorData20[L2_CACHE_SIZE * 4];
-Data20 *listData20[L2_CACHE_SIZE * 4];
+#define PREFETCH_TEST_COUNT 4
+
+const size_t prefetchDistances[] = {0, 1, 2, 4, 8, 16, 32, 64};
+const size_t prefetchDistanceCount = sizeof(prefetchDistances) / sizeof(prefetchDistances[0]);
+
+volatile float prefetchSink;
 
-void TEST(size_t sampleCount)
+//! ns per element for every distance, list[] has to hold random addresses already
+template<auto hint, typename TestData>
+void SweepPrefetchDistance(size_t sampleCount, TestData **list, double *times)
 {
-    uint32_t count = TEST_COUNT;
+    for (size_t d = 0; d < prefetchDistanceCount; ++d)
+    {
+        uint64_t time = 0;
+        float sum = 0.f;
+        for (uint32_t count = 0; count < PREFETCH_TEST_COUNT; ++count)
+        {
+            sum += TestPrefetchedAccess<hint>(sampleCount, list, prefetchDistances[d], time);
+        }
+        prefetchSink = sum;
+        times[d] = static_cast<double>(time) / (static_cast<double>(sampleCount) * PREFETCH_TEST_COUNT);
+    }
+}
+
+template<typename TestData>
+void TestPrefetch(const char *name, size_t sampleCount, TestData *vector, TestData **list)
+{
+    //! GENERATE RANDOM ADDRESS LIST, SAME ONE FOR EVERY HINT AND DISTANCE
+    for (size_t i = 0; i < sampleCount; ++i)
+    {
+        size_t index = RANDOM32BITADDRESS() % (sampleCount - 1);
+        list[i] = &vector[index];
+    }
+
+    const char *hintNames[] = {"T0", "T1", "T2", "NTA"};
+    double times[4][prefetchDistanceCount];
+    SweepPrefetchDistance<_MM_HINT_T0>(sampleCount, list, times[0]);
+    SweepPrefetchDistance<_MM_HINT_T1>(sampleCount, list, times[1]);
+    SweepPrefetchDistance<_MM_HINT_T2>(sampleCount, list, times[2]);
+    SweepPrefetchDistance<_MM_HINT_NTA>(sampleCount, list, times[3]);
+
+    printf("TEST %s random read with prefetch, ns per element \n", name);
+    printf("distance");
+    for (size_t d = 0; d < prefetchDistanceCount; ++d)
+    {
+        printf(" %6zu", prefetchDistances[d]);
+    }
+    printf("\n");
+
+    //! DISTANCE 0 IS THE NO PREFETCH BASELINE, BEST OF ALL HINTS SO THE SPEEDUP ISN'T COMPARED TO A NOISY RUN
+    double baseline = times[0][0];
+    size_t bestHint = 0;
+    //! BEST OF THE PREFETCHING RUNS ONLY, EVEN WHEN NONE BEATS THE BASELINE
+    size_t bestDistance = 1;
+    for (size_t h = 0; h < 4; ++h)
+    {
+        printf("%8s", hintNames[h]);
+        for (size_t d = 0; d < prefetchDistanceCount; ++d)
+        {
+            printf(" %6.2f", times[h][d]);
+            if (d == 0 && times[h][d] < baseline)
+            {
+                baseline = times[h][d];
+            }
+            if (d > 0 && times[h][d] < times[bestHint][bestDistance])
+            {
+                bestHint = h;
+                bestDistance = d;
+            }
+        }
+        printf("\n");
+    }
+    printf("Best distance %zu, hint %s, speedup over no prefetch %.2fx \n", prefetchDistances[bestDistance], hintNames[bestHint],
+           baseline / times[bestHint][bestDistance]);
+}
+
+//! Point into page buffers allocated in main, sized for the largest test
+Data16 *vectorData16;
+Data16 **listData16;
+Data20 *vectorData20;
+Data20 **listData20;
+
+PageBuffer bufferVectorData16;
+PageBuffer bufferListData16;
+PageBuffer bufferVectorData20;
+PageBuffer bufferListData20;
+
+void AllocateTestBuffers(size_t maxSampleCount, PageKind kind)
+{
+    //! FREE THE PREVIOUS BUFFERS FIRST, MEMORY SIZED ONES DON'T FIT TWICE ON SMALL MACHINES
+    bufferVectorData16 = PageBuffer();
+    bufferListData16 = PageBuffer();
+    bufferVectorData20 = PageBuffer();
+    bufferListData20 = PageBuffer();
+
+    bufferVectorData16 = PageBuffer(maxSampleCount * sizeof(Data16), kind);
+    bufferListData16 = PageBuffer(maxSampleCount * sizeof(Data16 *), kind);
+    bufferVectorData20 = PageBuffer(maxSampleCount * sizeof(Data20), kind);
+    bufferListData20 = PageBuffer(maxSampleCount * sizeof(Data20 *), kind);
+
+    vectorData16 = static_cast<Data16 *>(bufferVectorData16.GetData());
+    listData16 = static_cast<Data16 **>(bufferListData16.GetData());
+    vectorData20 = static_cast<Data20 *>(bufferVectorData20.GetData());
+    listData20 = static_cast<Data20 **>(bufferListData20.GetData());
+}
+
+//! ms per pass
+struct TestTimes
+{
+    double seqReadData16;
+    double randReadData16;
+    double seqReadData20;
+    double randReadData20;
+};
+
+volatile float testSink;
+
+TestTimes TEST(size_t sampleCount, uint32_t testCount = TEST_COUNT)
+{
+    uint32_t count = testCount;
     uint64_t seqReadTimeData16 = 0.0;
     uint64_t randReadTimeData16 = 0.0;
+    float sum = 0.f;
 
     while (count--)
     {
-        TestMemAccess<Data16>(sampleCount, vectorData16, listData16, sizeof(Data16), seqReadTimeData16, randReadTimeData16);
+        sum += TestMemAccess<Data16>(sampleCount, vectorData16, listData16, seqReadTimeData16, randReadTimeData16);
     }
 
     uint64_t seqReadTimeData20 = 0.0;
     uint64_t randReadTimeData20 = 0.0;
-    count = TEST_COUNT;
+    count = testCount;
 
     while (count--)
     {
-        TestMemAccess<Data20>(sampleCount, vectorData20, listData20, sizeof(Data20), seqReadTimeData20, randReadTimeData20);
+        sum += TestMemAccess<Data20>(sampleCount, vectorData20, listData20, seqReadTimeData20, randReadTimeData20);
     }
+    testSink = sum;
+
+    TestTimes times;
+    times.seqReadData16 = static_cast<double>(seqReadTimeData16) * 1e-6 / testCount;
+    times.randReadData16 = static_cast<double>(randReadTimeData16) * 1e-6 / testCount;
+    times.seqReadData20 = static_cast<double>(seqReadTimeData20) * 1e-6 / testCount;
+    times.randReadData20 = static_cast<double>(randReadTimeData20) * 1e-6 / testCount;
 
     printf("TEST Data Packed 16 \n");
-    printf("Sequence read from vector %f ms \n", static_cast<double>(seqReadTimeData16) * 1e-6 / TEST_COUNT);
-    printf("Random read from vector %f ms \n", static_cast<double>(randReadTimeData16) * 1e-6 / TEST_COUNT);
+    printf("Sequence read from vector %f ms \n", times.seqReadData16);
+    printf("Random read from vector %f ms \n", times.randReadData16);
     printf("TEST Data Packed 20 \n");
-    printf("Sequence read from vector %f ms \n", static_cast<double>(seqReadTimeData20) * 1e-6 / TEST_COUNT);
-    printf("Random read from vector %f ms \n", static_cast<double>(randReadTimeData20) * 1e-6 / TEST_COUNT);
+    printf("Sequence read from vector %f ms \n", times.seqReadData20);
+    printf("Random read from vector %f ms \n", times.randReadData20);
+    return times;
+}
+
+void TEST_PREFETCH(size_t sampleCount)
+{
+    TestPrefetch<Data16>("Data Packed 16", sampleCount, vectorData16, listData16);
+    TestPrefetch<Data20>("Data Packed 20", sampleCount, vectorData20, listData20);
 }
 
+//! Share of the time saved by huge pages, the part of the small page time spent on TLB misses and page walks
+double TlbShare(double smallPageTime, double hugePageTime)
+{
+    return smallPageTime > 0.0 ? (smallPageTime - hugePageTime) / smallPageTime * 100.0 : 0.0;
+}
+
+#define MEMORY_TEST_COUNT 4
+
 //!===========MAIN===========
-int main()
+//! cache_perf              sequential, random and prefetched random reads on small pages
+//! cache_perf --huge-pages sequential and random reads on small and huge pages, and the TLB share of their cost
+int main(int argc, char **argv)
 {
-    printf("TEST quarter cache used \n");
-    TEST((L2_CACHE_SIZE / 4) / 16);
-    printf("---\n");
-    printf("TEST half cache used \n");
-    TEST((L2_CACHE_SIZE / 2) / 16);
-    printf("---\n");
-    printf("TEST full cache used \n");
-    TEST(L2_CACHE_SIZE / 16);
-    printf("---\n");
-    printf("TEST double cache used \n");
-    TEST((L2_CACHE_SIZE * 2) / 16);
-    printf("---\n");
-    printf("TEST quadruple cache used \n");
-    TEST((L2_CACHE_SIZE * 4) / 16);
+    if (CacheTopology::GetDataCacheSize(2) > 0)
+    {
+        l2CacheSize = CacheTopology::GetDataCacheSize(2);
+    }
+    printf("L2 size: %zu KiB \n", l2CacheSize / 1024);
+
+    size_t largestCacheSize = l2CacheSize;
+    for (const CacheLevel &cache : CacheTopology::GetCaches())
+    {
+        largestCacheSize = std::max<size_t>(largestCacheSize, cache.Size);
+    }
+    //! memory sized set is 4 times the last cache, between 256 and 512 MiB
+    const size_t memorySize = std::clamp<size_t>(largestCacheSize * 4, 256llu << 20, 512llu << 20);
+
+    const size_t maxSampleCount = std::max(l2CacheSize * 4, memorySize) / 16;
+
+    struct TestSize
+    {
+        const char *name;
+        size_t sampleCount;
+    };
+    const TestSize testSizes[] = {
+        {"quarter cache", (l2CacheSize / 4) / 16},
+        {"half cache", (l2CacheSize / 2) / 16},
+        {"full cache", l2CacheSize / 16},
+        {"double cache", (l2CacheSize * 2) / 16},
+        {"quadruple cache", (l2CacheSize * 4) / 16},
+    };
+    const size_t testSizeCount = sizeof(testSizes) / sizeof(testSizes[0]);
+
+    if (argc < 2 || strcmp(argv[1], "--huge-pages") != 0)
+    {
+        AllocateTestBuffers(maxSampleCount, PageKind::Small);
+        for (size_t s = 0; s < testSizeCount; ++s)
+        {
+            printf("TEST %s used \n", testSizes[s].name);
+            TEST(testSizes[s].sampleCount);
+            TEST_PREFETCH(testSizes[s].sampleCount);
+            printf("---\n");
+        }
+        printf("TEST memory sized, %zu MiB \n", memorySize >> 20);
+        TEST_PREFETCH(memorySize / 16);
+        return 0;
+    }
+
+    //! SAME SWEEPS ON SMALL PAGES AND ON THE LARGEST HUGE PAGES THE SYSTEM GIVES, PLUS A MEMORY SIZED SET WHERE THE TLB MATTERS MOST
+    const PageKind pageKinds[] = {PageKind::Small, PageKind::ExplicitHuge};
+    TestTimes times[2][testSizeCount + 1];
+    double hugePageShares[2] = {0.0, 0.0};
+    for (size_t k = 0; k < 2; ++k)
+    {
+        AllocateTestBuffers(maxSampleCount, pageKinds[k]);
+        //! TRANSPARENT HUGE PAGES ARE BEST EFFORT, SO WHAT THE KERNEL ACTUALLY GAVE IS PRINTED
+        hugePageShares[k] = static_cast<double>(bufferVectorData16.GetHugePageBytes()) / static_cast<double>(bufferVectorData16.GetSize()) * 100.0;
+        printf("=== %s, huge page size %llu KiB, %.1f%% of the buffer on huge pages ===\n", PageBuffer::ToString(bufferVectorData16.GetPageKind()),
+               static_cast<unsigned long long>(PageBuffer::GetHugePageSize() / 1024), hugePageShares[k]);
+
+        for (size_t s = 0; s < testSizeCount; ++s)
+        {
+            printf("TEST %s used \n", testSizes[s].name);
+            times[k][s] = TEST(testSizes[s].sampleCount);
+            printf("---\n");
+        }
+        printf("TEST memory sized, %zu MiB \n", memorySize >> 20);
+        times[k][testSizeCount] = TEST(memorySize / 16, MEMORY_TEST_COUNT);
+        printf("---\n");
+    }
+
+    if (hugePageShares[1] == 0.0)
+    {
+        printf("No huge pages, reserve some in /proc/sys/vm/nr_hugepages or enable transparent huge pages, the TLB share below is noise \n");
+    }
+    if (hugePageShares[0] > 0.0)
+    {
+        printf("Small page buffers are %.1f%% on huge pages, the TLB share below is understated \n", hugePageShares[0]);
+    }
+    printf("TLB share of the read time, (small pages - huge pages) / small pages \n");
+    printf("%16s %10s %10s %10s %10s\n", "working set", "seq 16", "rand 16", "seq 20", "rand 20");
+    for (size_t s = 0; s <= testSizeCount; ++s)
+    {
+        printf("%16s %9.1f%% %9.1f%% %9.1f%% %9.1f%%\n", s < testSizeCount ? testSizes[s].name : "memory sized",
+               TlbShare(times[0][s].seqReadData16, times[1][s].seqReadData16), TlbShare(times[0][s].randReadData16, times[1][s].randReadData16),
+               TlbShare(times[0][s].seqReadData20, times[1][s].seqReadData20), TlbShare(times[0][s].randReadData20, times[1][s].randReadData20));
+    }
     return 0;
 }
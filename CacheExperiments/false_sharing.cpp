@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <cstdint>
+#include <cstdio>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "CacheTopology.h"
+#include "PerformanceCounter.h"
+
+// Every thread increments only its own counter, threads never share data, only cache lines.
+// When counters of different threads sit in one line, every write invalidates the line in all other cores
+// and throughput falls with each added thread, even though there is nothing to synchronize.
+
+#if defined(__cpp_lib_hardware_interference_size)
+constexpr size_t DestructiveInterferenceSize = std::hardware_destructive_interference_size;
+#else
+constexpr size_t DestructiveInterferenceSize = 64;
+#endif
+
+constexpr uint64_t IncrementsPerThread = 2e7;
+
+struct alignas(DestructiveInterferenceSize) PaddedCounter
+{
+    uint64_t Value = 0;
+};
+
+struct alignas(DestructiveInterferenceSize) PaddedAtomicCounter
+{
+    std::atomic<uint64_t> Value = 0;
+};
+
+// Counters of all threads, the layout under test
+struct CounterArrays
+{
+    std::vector<uint64_t> Packed;
+    std::vector<PaddedCounter> Padded;
+    std::vector<std::atomic<uint64_t>> PackedAtomic;
+    std::vector<PaddedAtomicCounter> PaddedAtomic;
+
+    explicit CounterArrays(const uint32_t NumThreads)
+        : Packed(NumThreads)
+        , Padded(NumThreads)
+        , PackedAtomic(NumThreads)
+        , PaddedAtomic(NumThreads)
+    {
+    }
+};
+
+using IncrementFunction = void (*)(CounterArrays& Counters, uint32_t ThreadIndex);
+
+// volatile keeps every increment a load and a store, like a counter updated from a real work loop
+void IncrementPacked(CounterArrays& Counters, const uint32_t ThreadIndex)
+{
+    volatile uint64_t& Counter = Counters.Packed[ThreadIndex];
+    for (uint64_t Increment = 0; Increment < IncrementsPerThread; ++Increment)
+    {
+        Counter = Counter + 1;
+    }
+}
+
+void IncrementPadded(CounterArrays& Counters, const uint32_t ThreadIndex)
+{
+    volatile uint64_t& Counter = Counters.Padded[ThreadIndex].Value;
+    for (uint64_t Increment = 0; Increment < IncrementsPerThread; ++Increment)
+    {
+        Counter = Counter + 1;
+    }
+}
+
+void IncrementPackedAtomic(CounterArrays& Counters, const uint32_t ThreadIndex)
+{
+    std::atomic<uint64_t>& Counter = Counters.PackedAtomic[ThreadIndex];
+    for (uint64_t Increment = 0; Increment < IncrementsPerThread; ++Increment)
+    {
+        Counter.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void IncrementPaddedAtomic(CounterArrays& Counters, const uint32_t ThreadIndex)
+{
+    std::atomic<uint64_t>& Counter = Counters.PaddedAtomic[ThreadIndex].Value;
+    for (uint64_t Increment = 0; Increment < IncrementsPerThread; ++Increment)
+    {
+        Counter.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Accumulates in a local and publishes once into the packed array, the line is shared only for the final store
+void IncrementLocalThenPublish(CounterArrays& Counters, const uint32_t ThreadIndex)
+{
+    volatile uint64_t Local = 0;
+    for (uint64_t Increment = 0; Increment < IncrementsPerThread; ++Increment)
+    {
+        Local = Local + 1;
+    }
+
+    Counters.Packed[ThreadIndex] = Local;
+}
+
+struct CounterLayout
+{
+    const char* Name;
+    IncrementFunction Function;
+};
+
+constexpr CounterLayout Layouts[] = {
+    {"packed", IncrementPacked},
+    {"padded", IncrementPadded},
+    {"packed atomic", IncrementPackedAtomic},
+    {"padded atomic", IncrementPaddedAtomic},
+    {"local + publish", IncrementLocalThenPublish},
+};
+
+uint64_t SumCounters(const CounterArrays& Counters)
+{
+    uint64_t Result = 0;
+    for (size_t ThreadIndex = 0; ThreadIndex < Counters.Packed.size(); ++ThreadIndex)
+    {
+        Result += Counters.Packed[ThreadIndex] + Counters.Padded[ThreadIndex].Value + Counters.PackedAtomic[ThreadIndex].load()
+            + Counters.PaddedAtomic[ThreadIndex].Value.load();
+    }
+
+    return Result;
+}
+
+// Millions of increments per second summed over all threads
+double MeasureThroughput(const CounterLayout& Layout, const uint32_t NumThreads, bool& bOutCorrect)
+{
+    CounterArrays Counters(NumThreads);
+    std::barrier Barrier(NumThreads + 1);
+
+    std::vector<std::thread> Threads;
+    for (uint32_t ThreadIndex = 0; ThreadIndex < NumThreads; ++ThreadIndex)
+    {
+        Threads.emplace_back([&, ThreadIndex]()
+        {
+            Barrier.arrive_and_wait();
+            Layout.Function(Counters, ThreadIndex);
+        });
+    }
+
+    // timer starts before the barrier opens, workers may run before this thread is scheduled again
+    PerformanceCounter PerfCounter;
+    PerfCounter.Reset();
+    Barrier.arrive_and_wait();
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+    const double Time = PerfCounter.Elapsed();
+
+    bOutCorrect &= SumCounters(Counters) == IncrementsPerThread * NumThreads;
+    return static_cast<double>(IncrementsPerThread * NumThreads) / (Time * 1e3);
+}
+
+std::vector<uint32_t> MakeThreadCounts()
+{
+    const uint32_t MaxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    std::vector<uint32_t> Result;
+    for (uint32_t NumThreads = 1; NumThreads < MaxThreads; NumThreads *= 2)
+    {
+        Result.push_back(NumThreads);
+    }
+    Result.push_back(MaxThreads);
+
+    return Result;
+}
+
+int main()
+{
+    std::printf("cache line: %u B, padding to: %zu B, %llu increments per thread\n", CacheTopology::GetCacheLineSize(),
+                DestructiveInterferenceSize, static_cast<unsigned long long>(IncrementsPerThread));
+
+    std::printf("threads");
+    for (const CounterLayout& Layout : Layouts)
+    {
+        std::printf(" %16s", Layout.Name);
+    }
+    std::printf("   (M increments/s)\n");
+
+    bool bCorrect = true;
+    for (const uint32_t NumThreads : MakeThreadCounts())
+    {
+        std::printf("%7u", NumThreads);
+        for (const CounterLayout& Layout : Layouts)
+        {
+            std::printf(" %16.1f", MeasureThroughput(Layout, NumThreads, bCorrect));
+        }
+        std::printf("\n");
+    }
+
+    std::printf("Correct: %s\n", bCorrect ? "True" : "False");
+    return 0;
+}
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CacheTopology.h"
+#include "DataLayout.h"
+#include "PerformanceCounter.h"
+
+// Reads 1, 2 or all fields of every entity, sequentially and in random order, for each layout and working set.
+// AoS drags the unused fields through the caches, SoA streams only the used ones but random access touches
+// one line per field, AoSoA keeps an entity within a few lines while sequential reads still use whole lines.
+
+using Data16 = FieldList<float, float, float, float>;
+using Data20 = FieldList<float, float, float, float, float>;
+// wide entity, hot loops usually touch a couple of its fields
+using Data64 = FieldList<float, float, float, float, float, float, float, float, float, float, float, float, float, float, float, float>;
+
+// working sets of a single sequential pass are repeated until at least this many entities are read
+constexpr uint64_t MinAccesses = 1llu << 22;
+// random order is a precomputed index list, its length caps the time spent in memory sized working sets
+constexpr uint64_t MaxRandomAccesses = 1llu << 22;
+
+constexpr uint64_t MinMemoryWorkingSet = 256llu << 20;
+constexpr uint64_t MaxMemoryWorkingSet = 512llu << 20;
+
+// entities are processed four at a time into separate sums, so add latency doesn't hide memory differences
+constexpr uint64_t EntitiesPerIteration = 4;
+
+volatile float Sink;
+
+struct WorkingSetLevel
+{
+    std::string Name;
+    uint64_t Bytes;
+};
+
+// Half of every data cache and one working set far larger than the last cache
+std::vector<WorkingSetLevel> MakeWorkingSetLevels()
+{
+    std::vector<WorkingSetLevel> Result;
+
+    uint64_t LargestCache = 0;
+    for (const CacheLevel& Cache : CacheTopology::GetCaches())
+    {
+        if (Cache.Type != CacheType::Instruction)
+        {
+            Result.push_back({"L" + std::to_string(Cache.Level), std::min(Cache.Size / 2, MaxMemoryWorkingSet)});
+            LargestCache = std::max(LargestCache, Cache.Size);
+        }
+    }
+
+    Result.push_back({"DRAM", std::clamp(LargestCache * 4, MinMemoryWorkingSet, MaxMemoryWorkingSet)});
+    return Result;
+}
+
+template <size_t NumFields, typename LayoutType>
+float SumFields(LayoutType& Storage, const size_t Index)
+{
+    return [&]<size_t... FieldIndexes>(std::index_sequence<FieldIndexes...>)
+    {
+        return (Storage.template Get<FieldIndexes>(Index) + ...);
+    }(std::make_index_sequence<NumFields>());
+}
+
+// AoSoA, read block by block so its loops do the same work per entity as the other layouts
+template <typename LayoutType>
+concept BlockLayout = requires(LayoutType& Storage)
+{
+    Storage.template GetBlock<0>(0);
+};
+
+template <size_t NumFields, typename LayoutType>
+float SumBlockFields(LayoutType& Storage, const size_t BlockIndex, const size_t Lane)
+{
+    return [&]<size_t... FieldIndexes>(std::index_sequence<FieldIndexes...>)
+    {
+        return (Storage.template GetBlock<FieldIndexes>(BlockIndex)[Lane] + ...);
+    }(std::make_index_sequence<NumFields>());
+}
+
+// random entities of AoSoA are split into block and lane once, not once per field
+template <size_t NumFields, typename LayoutType>
+float SumEntityFields(LayoutType& Storage, const size_t Index)
+{
+    if constexpr (BlockLayout<LayoutType>)
+    {
+        return SumBlockFields<NumFields>(Storage, Index / LayoutType::Width, Index % LayoutType::Width);
+    }
+    else
+    {
+        return SumFields<NumFields>(Storage, Index);
+    }
+}
+
+// Nanoseconds per entity
+template <size_t NumFields, typename LayoutType>
+double MeasureSequential(LayoutType& Storage)
+{
+    const uint64_t NumPasses = std::max<uint64_t>(MinAccesses / Storage.size(), 1);
+    float Sum0 = 0.f;
+    float Sum1 = 0.f;
+    float Sum2 = 0.f;
+    float Sum3 = 0.f;
+
+    PerformanceCounter PerfCounter;
+    PerfCounter.Reset();
+    for (uint64_t PassIndex = 0; PassIndex < NumPasses; ++PassIndex)
+    {
+        if constexpr (BlockLayout<LayoutType>)
+        {
+            static_assert(LayoutType::Width % EntitiesPerIteration == 0, "a block is read in whole iterations");
+
+            for (size_t BlockIndex = 0; BlockIndex < Storage.NumBlocks(); ++BlockIndex)
+            {
+                // the last block may be partly used, the entity count is still a multiple of EntitiesPerIteration
+                const size_t NumLanes = std::min<size_t>(LayoutType::Width, Storage.size() - BlockIndex * LayoutType::Width);
+                for (size_t Lane = 0; Lane < NumLanes; Lane += EntitiesPerIteration)
+                {
+                    Sum0 += SumBlockFields<NumFields>(Storage, BlockIndex, Lane);
+                    Sum1 += SumBlockFields<NumFields>(Storage, BlockIndex, Lane + 1);
+                    Sum2 += SumBlockFields<NumFields>(Storage, BlockIndex, Lane + 2);
+                    Sum3 += SumBlockFields<NumFields>(Storage, BlockIndex, Lane + 3);
+                }
+            }
+        }
+        else
+        {
+            for (size_t Index = 0; Index < Storage.size(); Index += EntitiesPerIteration)
+            {
+                Sum0 += SumFields<NumFields>(Storage, Index);
+                Sum1 += SumFields<NumFields>(Storage, Index + 1);
+                Sum2 += SumFields<NumFields>(Storage, Index + 2);
+                Sum3 += SumFields<NumFields>(Storage, Index + 3);
+            }
+        }
+    }
+    const double Time = PerfCounter.Elapsed();
+
+    Sink = Sum0 + Sum1 + Sum2 + Sum3;
+    return Time * 1e6 / static_cast<double>(NumPasses * Storage.size());
+}
+
+template <size_t NumFields, typename LayoutType>
+double MeasureRandom(LayoutType& Storage, const std::vector<uint32_t>& Indexes)
+{
+    const uint64_t NumPasses = std::max<uint64_t>(MinAccesses / Indexes.size(), 1);
+    float Sum0 = 0.f;
+    float Sum1 = 0.f;
+    float Sum2 = 0.f;
+    float Sum3 = 0.f;
+
+    PerformanceCounter PerfCounter;
+    PerfCounter.Reset();
+    for (uint64_t PassIndex = 0; PassIndex < NumPasses; ++PassIndex)
+    {
+        for (size_t Index = 0; Index < Indexes.size(); Index += EntitiesPerIteration)
+        {
+            Sum0 += SumEntityFields<NumFields>(Storage, Indexes[Index]);
+            Sum1 += SumEntityFields<NumFields>(Storage, Indexes[Index + 1]);
+            Sum2 += SumEntityFields<NumFields>(Storage, Indexes[Index + 2]);
+            Sum3 += SumEntityFields<NumFields>(Storage, Indexes[Index + 3]);
+        }
+    }
+    const double Time = PerfCounter.Elapsed();
+
+    Sink = Sum0 + Sum1 + Sum2 + Sum3;
+    return Time * 1e6 / static_cast<double>(NumPasses * Indexes.size());
+}
+
+template <typename LayoutType, size_t... FieldIndexes>
+void FillFields(LayoutType& Storage, std::index_sequence<FieldIndexes...>)
+{
+    for (size_t Index = 0; Index < Storage.size(); ++Index)
+    {
+        ((Storage.template Get<FieldIndexes>(Index) = static_cast<float>(Index + FieldIndexes)), ...);
+    }
+}
+
+template <typename Entity, typename LayoutType>
+void TestLayout(const uint64_t NumEntities, const std::vector<uint32_t>& Indexes)
+{
+    LayoutType Storage;
+    Storage.resize(NumEntities);
+    FillFields(Storage, std::make_index_sequence<Entity::NumFields>());
+
+    std::printf("%9s %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f\n", LayoutType::Name, MeasureSequential<1>(Storage),
+                MeasureSequential<2>(Storage), MeasureSequential<Entity::NumFields>(Storage), MeasureRandom<1>(Storage, Indexes),
+                MeasureRandom<2>(Storage, Indexes), MeasureRandom<Entity::NumFields>(Storage, Indexes));
+}
+
+template <typename Entity>
+void TestEntity(const char* EntityName, const std::vector<WorkingSetLevel>& Levels)
+{
+    std::mt19937 RandomGenerator;
+
+    for (const WorkingSetLevel& Level : Levels)
+    {
+        const uint64_t NumEntities = Level.Bytes / Entity::EntitySize / EntitiesPerIteration * EntitiesPerIteration;
+
+        std::uniform_int_distribution<uint32_t> Distribution(0, static_cast<uint32_t>(NumEntities - 1));
+        std::vector<uint32_t> Indexes(std::min(NumEntities, MaxRandomAccesses));
+        for (uint32_t& Index : Indexes)
+        {
+            Index = Distribution(RandomGenerator);
+        }
+
+        std::printf("%s, %s working set: %.1f KiB, %llu entities\n", EntityName, Level.Name.c_str(), static_cast<double>(Level.Bytes) / 1024.,
+                    static_cast<unsigned long long>(NumEntities));
+        std::printf("   layout     seq 1     seq 2   seq all    rand 1    rand 2  rand all   (ns per entity)\n");
+
+        TestLayout<Entity, AoS<Entity>>(NumEntities, Indexes);
+        TestLayout<Entity, SoA<Entity>>(NumEntities, Indexes);
+        TestLayout<Entity, AoSoA<Entity, 4>>(NumEntities, Indexes);
+        TestLayout<Entity, AoSoA<Entity, 8>>(NumEntities, Indexes);
+        TestLayout<Entity, AoSoA<Entity, 16>>(NumEntities, Indexes);
+        std::printf("\n");
+    }
+}
+
+int main()
+{
+    const std::vector<WorkingSetLevel> Levels = MakeWorkingSetLevels();
+
+    TestEntity<Data16>("Data16", Levels);
+    TestEntity<Data20>("Data20", Levels);
+    TestEntity<Data64>("Data64", Levels);
+
+    return 0;
+}
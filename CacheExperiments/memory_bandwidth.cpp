@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <barrier>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "CacheTopology.h"
+#include "PerformanceCounter.h"
+
+// STREAM style sustained bandwidth. Every thread runs the kernel over its own slice of the arrays,
+// working sets are picked so they fit in half of each cache level, the last one is far larger than any cache.
+// Bytes are counted like STREAM does: every array read or written once per element, write allocate traffic isn't counted.
+
+constexpr double Scalar = 3.;
+constexpr uint64_t ElementsPerLine = 64 / sizeof(double);
+
+// small working sets are passed over many times, so barriers and the timer don't matter
+constexpr uint64_t MinBytesPerTrial = 256llu << 20;
+// best of, like STREAM
+constexpr uint32_t NumTrials = 5;
+
+constexpr uint64_t MinMemoryWorkingSet = 256llu << 20;
+constexpr uint64_t MaxMemoryWorkingSet = 512llu << 20;
+
+using KernelFunction = void (*)(double* A, const double* B, const double* C, uint64_t Count);
+
+struct Kernel
+{
+    const char* Name;
+    KernelFunction Function;
+    // arrays read or written, the working set is split evenly between them
+    uint32_t NumArrays;
+};
+
+struct WorkingSetLevel
+{
+    std::string Name;
+    // bytes per thread for caches private to a core, total for memory
+    uint64_t Bytes;
+    bool bPerThread;
+};
+
+void Copy(double* A, const double* B, const double*, const uint64_t Count)
+{
+    for (uint64_t Index = 0; Index < Count; ++Index)
+    {
+        A[Index] = B[Index];
+    }
+}
+
+void Scale(double* A, const double* B, const double*, const uint64_t Count)
+{
+    for (uint64_t Index = 0; Index < Count; ++Index)
+    {
+        A[Index] = Scalar * B[Index];
+    }
+}
+
+void Add(double* A, const double* B, const double* C, const uint64_t Count)
+{
+    for (uint64_t Index = 0; Index < Count; ++Index)
+    {
+        A[Index] = B[Index] + C[Index];
+    }
+}
+
+void Triad(double* A, const double* B, const double* C, const uint64_t Count)
+{
+    for (uint64_t Index = 0; Index < Count; ++Index)
+    {
+        A[Index] = B[Index] + Scalar * C[Index];
+    }
+}
+
+// reads B only, the sum is stored so the loads can't be removed.
+// One line per iteration into four sums, so add latency doesn't limit cache bandwidth.
+void Read(double* A, const double* B, const double*, const uint64_t Count)
+{
+    __m128d Sum0 = _mm_setzero_pd();
+    __m128d Sum1 = _mm_setzero_pd();
+    __m128d Sum2 = _mm_setzero_pd();
+    __m128d Sum3 = _mm_setzero_pd();
+    for (uint64_t Index = 0; Index + ElementsPerLine <= Count; Index += ElementsPerLine)
+    {
+        Sum0 = _mm_add_pd(Sum0, _mm_load_pd(B + Index));
+        Sum1 = _mm_add_pd(Sum1, _mm_load_pd(B + Index + 2));
+        Sum2 = _mm_add_pd(Sum2, _mm_load_pd(B + Index + 4));
+        Sum3 = _mm_add_pd(Sum3, _mm_load_pd(B + Index + 6));
+    }
+
+    _mm_store_sd(A, _mm_add_pd(_mm_add_pd(Sum0, Sum1), _mm_add_pd(Sum2, Sum3)));
+}
+
+void Write(double* A, const double*, const double*, const uint64_t Count)
+{
+    std::fill(A, A + Count, Scalar);
+}
+
+// streaming stores skip the read for ownership of the line and don't pollute caches
+void WriteNonTemporal(double* A, const double*, const double*, const uint64_t Count)
+{
+    const __m128d Value = _mm_set1_pd(Scalar);
+    for (uint64_t Index = 0; Index + 2 <= Count; Index += 2)
+    {
+        _mm_stream_pd(A + Index, Value);
+    }
+
+    _mm_sfence();
+}
+
+constexpr Kernel Kernels[] = {
+    {"copy", Copy, 2},
+    {"scale", Scale, 2},
+    {"add", Add, 3},
+    {"triad", Triad, 3},
+    {"read", Read, 1},
+    {"write", Write, 1},
+    {"write nt", WriteNonTemporal, 1},
+};
+
+// Half of every data cache, split between the logical processors sharing it, and one working set in memory
+std::vector<WorkingSetLevel> MakeWorkingSetLevels()
+{
+    std::vector<WorkingSetLevel> Result;
+
+    uint64_t LargestCache = 0;
+    for (const CacheLevel& Cache : CacheTopology::GetCaches())
+    {
+        if (Cache.Type == CacheType::Instruction)
+        {
+            continue;
+        }
+
+        const uint64_t Bytes = Cache.Size / 2 / std::max(Cache.NumSharingProcessors, 1u);
+        Result.push_back({"L" + std::to_string(Cache.Level), Bytes / 64 * 64, true});
+        LargestCache = std::max(LargestCache, Cache.Size);
+    }
+
+    Result.push_back({"DRAM", std::clamp(LargestCache * 4, MinMemoryWorkingSet, MaxMemoryWorkingSet), false});
+    return Result;
+}
+
+std::vector<uint32_t> MakeThreadCounts()
+{
+    const uint32_t MaxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    std::vector<uint32_t> Result;
+    for (uint32_t NumThreads = 1; NumThreads < MaxThreads; NumThreads *= 2)
+    {
+        Result.push_back(NumThreads);
+    }
+    Result.push_back(MaxThreads);
+
+    return Result;
+}
+
+// Best bandwidth out of NumTrials in GB/s, threads wait on a barrier so they all start and stop together
+double MeasureBandwidth(const Kernel& InKernel, double* A, double* B, double* C, const uint64_t WorkingSet, const uint32_t NumThreads)
+{
+    // slices start on cache line boundary, so threads never write to the same line
+    const uint64_t NumElements = WorkingSet / (sizeof(double) * InKernel.NumArrays) / ElementsPerLine * ElementsPerLine;
+    const uint64_t SliceSize = NumElements / ElementsPerLine / NumThreads * ElementsPerLine;
+    const uint64_t BytesPerPass = SliceSize * NumThreads * sizeof(double) * InKernel.NumArrays;
+    const uint64_t NumPasses = std::max<uint64_t>(MinBytesPerTrial / BytesPerPass, 1);
+
+    std::barrier Barrier(NumThreads + 1);
+    std::vector<std::thread> Threads;
+    for (uint32_t ThreadIndex = 0; ThreadIndex < NumThreads; ++ThreadIndex)
+    {
+        Threads.emplace_back([&, ThreadIndex]()
+        {
+            const uint64_t Begin = ThreadIndex * SliceSize;
+            for (uint32_t TrialIndex = 0; TrialIndex < NumTrials; ++TrialIndex)
+            {
+                Barrier.arrive_and_wait();
+                for (uint64_t PassIndex = 0; PassIndex < NumPasses; ++PassIndex)
+                {
+                    InKernel.Function(A + Begin, B + Begin, C + Begin, SliceSize);
+                }
+                Barrier.arrive_and_wait();
+            }
+        });
+    }
+
+    double BestTime = std::numeric_limits<double>::max();
+    PerformanceCounter PerfCounter;
+    for (uint32_t TrialIndex = 0; TrialIndex < NumTrials; ++TrialIndex)
+    {
+        // timer starts before the barrier opens, after it workers may run before this thread is scheduled again
+        PerfCounter.Reset();
+        Barrier.arrive_and_wait();
+        Barrier.arrive_and_wait();
+        BestTime = std::min(BestTime, PerfCounter.Elapsed());
+    }
+
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+
+    return static_cast<double>(BytesPerPass * NumPasses) / (BestTime * 1e6);
+}
+
+int main()
+{
+    CacheTopology::Print();
+
+    const std::vector<WorkingSetLevel> Levels = MakeWorkingSetLevels();
+    const std::vector<uint32_t> ThreadCounts = MakeThreadCounts();
+
+    uint64_t MaxWorkingSet = 0;
+    for (const WorkingSetLevel& Level : Levels)
+    {
+        MaxWorkingSet = std::max(MaxWorkingSet, Level.bPerThread ? Level.Bytes * ThreadCounts.back() : Level.Bytes);
+    }
+
+    // single array kernels use the whole working set in A or B, three array ones a third of it in C
+    std::vector<double> A(MaxWorkingSet / sizeof(double), 0.);
+    std::vector<double> B(MaxWorkingSet / sizeof(double), 1.);
+    std::vector<double> C(MaxWorkingSet / sizeof(double) / 3 + ElementsPerLine, 2.);
+
+    for (const WorkingSetLevel& Level : Levels)
+    {
+        std::printf("\n%s working set: %.1f KiB%s\n", Level.Name.c_str(), static_cast<double>(Level.Bytes) / 1024., Level.bPerThread ? " per thread" : "");
+        std::printf("threads");
+        for (const Kernel& InKernel : Kernels)
+        {
+            std::printf(" %10s", InKernel.Name);
+        }
+        std::printf("   (GB/s)\n");
+
+        for (const uint32_t NumThreads : ThreadCounts)
+        {
+            const uint64_t WorkingSet = Level.bPerThread ? Level.Bytes * NumThreads : Level.Bytes;
+
+            std::printf("%7u", NumThreads);
+            for (const Kernel& InKernel : Kernels)
+            {
+                std::printf(" %10.1f", MeasureBandwidth(InKernel, A.data(), B.data(), C.data(), WorkingSet, NumThreads));
+            }
+            std::printf("\n");
+        }
+    }
+
+    return 0;
+}
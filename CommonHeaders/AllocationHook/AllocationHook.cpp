@@ -0,0 +1,228 @@
+#include "AllocationCounter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Replaces global operator new and delete, so every allocation of the program is counted.
+// Built as its own object library, only programs which read AllocationCounter link it and pay for the counting.
+
+namespace
+{
+    std::atomic<uint64_t> NumAllocations = 0;
+    std::atomic<uint64_t> NumDeallocations = 0;
+    std::atomic<uint64_t> BytesRequested = 0;
+    // live bytes of blocks allocated before Reset are subtracted when they are freed, so this can go below the baseline
+    std::atomic<int64_t> LiveBytes = 0;
+    std::atomic<int64_t> PeakLiveBytes = 0;
+    std::atomic<int64_t> BaselineLiveBytes = 0;
+
+    // Kept right in front of every block, so unsized delete knows how much was freed
+    struct BlockHeader
+    {
+        void* Allocation;
+        size_t Bytes;
+    };
+
+    static_assert(sizeof(BlockHeader) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+
+    BlockHeader* GetHeader(void* Pointer)
+    {
+        return static_cast<BlockHeader*>(Pointer) - 1;
+    }
+
+    void RecordAllocation(const size_t Bytes)
+    {
+        NumAllocations.fetch_add(1, std::memory_order_relaxed);
+        BytesRequested.fetch_add(Bytes, std::memory_order_relaxed);
+        const int64_t NewLiveBytes = LiveBytes.fetch_add(static_cast<int64_t>(Bytes), std::memory_order_relaxed) + static_cast<int64_t>(Bytes);
+
+        int64_t Peak = PeakLiveBytes.load(std::memory_order_relaxed);
+        while (NewLiveBytes > Peak && !PeakLiveBytes.compare_exchange_weak(Peak, NewLiveBytes, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // Alignment has to be a power of two, header takes a whole alignment unit in front of the block
+    void* CountedAllocate(const size_t Bytes, const size_t Alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    {
+        const size_t HeaderSize = std::max<size_t>(Alignment, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+        // malloc already aligns to the default alignment, stricter ones need room for moving the block up
+        const size_t Padding = HeaderSize - __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+        // size of the whole block would wrap around, malloc would return a block smaller than requested
+        if (Bytes > SIZE_MAX - HeaderSize - Padding)
+        {
+            return nullptr;
+        }
+
+        void* Allocation = std::malloc(Bytes + HeaderSize + Padding);
+        if (Allocation == nullptr)
+        {
+            return nullptr;
+        }
+
+        const uintptr_t Address = reinterpret_cast<uintptr_t>(Allocation) + HeaderSize;
+        void* Result = reinterpret_cast<void*>((Address + HeaderSize - 1) & ~(HeaderSize - 1));
+        *GetHeader(Result) = {Allocation, Bytes};
+
+        RecordAllocation(Bytes);
+        return Result;
+    }
+
+    void CountedDeallocate(void* Pointer)
+    {
+        if (Pointer == nullptr)
+        {
+            return;
+        }
+
+        const BlockHeader Header = *GetHeader(Pointer);
+
+        NumDeallocations.fetch_add(1, std::memory_order_relaxed);
+        LiveBytes.fetch_sub(static_cast<int64_t>(Header.Bytes), std::memory_order_relaxed);
+
+        std::free(Header.Allocation);
+    }
+}
+
+void AllocationCounter::Reset()
+{
+    NumAllocations = 0;
+    NumDeallocations = 0;
+    BytesRequested = 0;
+
+    const int64_t CurrentLiveBytes = LiveBytes.load();
+    BaselineLiveBytes = CurrentLiveBytes;
+    PeakLiveBytes = CurrentLiveBytes;
+}
+
+AllocationStats AllocationCounter::GetStats()
+{
+    const int64_t Baseline = BaselineLiveBytes.load();
+
+    AllocationStats Result;
+    Result.NumAllocations = NumAllocations.load();
+    Result.NumDeallocations = NumDeallocations.load();
+    Result.BytesRequested = BytesRequested.load();
+    Result.LiveBytes = static_cast<uint64_t>(std::max<int64_t>(LiveBytes.load() - Baseline, 0));
+    Result.PeakLiveBytes = static_cast<uint64_t>(std::max<int64_t>(PeakLiveBytes.load() - Baseline, 0));
+
+    return Result;
+}
+
+// Replaceable global allocation functions
+
+void* operator new(const size_t Bytes)
+{
+    void* Result = CountedAllocate(Bytes);
+    if (Result == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return Result;
+}
+
+void* operator new[](const size_t Bytes)
+{
+    return operator new(Bytes);
+}
+
+void* operator new(const size_t Bytes, const std::nothrow_t&) noexcept
+{
+    return CountedAllocate(Bytes);
+}
+
+void* operator new[](const size_t Bytes, const std::nothrow_t&) noexcept
+{
+    return CountedAllocate(Bytes);
+}
+
+void operator delete(void* Pointer) noexcept
+{
+    CountedDeallocate(Pointer);
+}
+
+void operator delete[](void* Pointer) noexcept
+{
+    CountedDeallocate(Pointer);
+}
+
+void operator delete(void* Pointer, size_t) noexcept
+{
+    CountedDeallocate(Pointer);
+}
+
+void operator delete[](void* Pointer, size_t) noexcept
+{
+    CountedDeallocate(Pointer);
+}
+
+void operator delete(void* Pointer, const std::nothrow_t&) noexcept
+{
+    CountedDeallocate(Pointer);
+}
+
+void operator delete[](void* Pointer, const std::nothrow_t&) noexcept
+{
+    CountedDeallocate(Pointer);
+}
+
+void* operator new(const size_t Bytes, const std::align_val_t Alignment)
+{
+    void* Result = CountedAllocate(Bytes, static_cast<size_t>(Alignment));
+    if (Result == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return Result;
+}
+
+void* operator new[](const size_t Bytes, const std::align_val_t Alignment)
+{
+    return operator new(Bytes, Alignment);
+}
+
+void* operator new(const size_t Bytes, const std::align_val_t Alignment, const std::nothrow_t&) noexcept
+{
+    return CountedAllocate(Bytes, static_cast<size_t>(Alignment));
+}
+
+void* operator new[](const size_t Bytes, const std::align_val_t Alignment, const std::nothrow_t&) noexcept
+{
+    return CountedAllocate(Bytes, static_cast<size_t>(Alignment));
+}
+
+void operator delete(void* Pointer, std::align_val_t) noexcept
+{
+    CountedDeallocate(Pointer);
+}
+
+void operator delete[](void* Pointer, std::align_val_t) noexcept
+{
+    CountedDeallocate(Pointer);
+}
+
+void operator delete(void* Pointer, size_t, std::align_val_t) noexcept
+{
+    CountedDeallocate(Pointer);
+}
+
+void operator delete[](void* Pointer, size_t, std::align_val_t) noexcept
+{
+    CountedDeallocate(Pointer);
+}
+
+void operator delete(void* Pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    CountedDeallocate(Pointer);
+}
+
+void operator delete[](void* Pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    CountedDeallocate(Pointer);
+}
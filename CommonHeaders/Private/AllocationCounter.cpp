@@ -0,0 +1,50 @@
+#include "AllocationCounter.h"
+
+#include <algorithm>
+#include <cstdio>
+
+void AllocationStats::RecordAllocation(const uint64_t Bytes)
+{
+    ++NumAllocations;
+    BytesRequested += Bytes;
+    LiveBytes += Bytes;
+    PeakLiveBytes = std::max(PeakLiveBytes, LiveBytes);
+}
+
+void AllocationStats::RecordDeallocation(const uint64_t Bytes)
+{
+    ++NumDeallocations;
+    LiveBytes -= Bytes;
+}
+
+double AllocationStats::GetMeanAllocationSize() const
+{
+    return NumAllocations > 0 ? static_cast<double>(BytesRequested) / static_cast<double>(NumAllocations) : 0.;
+}
+
+std::string AllocationStats::ToString() const
+{
+    char Buffer[160];
+    std::snprintf(Buffer, sizeof(Buffer), "allocations: %llu, frees: %llu, requested: %.1f KiB, peak live: %.1f KiB, mean size: %.1f B",
+                  static_cast<unsigned long long>(NumAllocations), static_cast<unsigned long long>(NumDeallocations),
+                  static_cast<double>(BytesRequested) / 1024., static_cast<double>(PeakLiveBytes) / 1024., GetMeanAllocationSize());
+
+    return Buffer;
+}
+
+void* CountingResource::do_allocate(const size_t Bytes, const size_t Alignment)
+{
+    Stats->RecordAllocation(Bytes);
+    return Upstream->allocate(Bytes, Alignment);
+}
+
+void CountingResource::do_deallocate(void* Pointer, const size_t Bytes, const size_t Alignment)
+{
+    Stats->RecordDeallocation(Bytes);
+    Upstream->deallocate(Pointer, Bytes, Alignment);
+}
+
+bool CountingResource::do_is_equal(const std::pmr::memory_resource& Other) const noexcept
+{
+    return this == &Other;
+}
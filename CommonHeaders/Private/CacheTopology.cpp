@@ -0,0 +1,330 @@
+#include "CacheTopology.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <string>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#include <bit>
+#elif defined(__APPLE__)
+#include <sys/sysctl.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace
+{
+    constexpr uint32_t DefaultCacheLineSize = 64;
+
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    void ReadCpuid(const uint32_t Leaf, const uint32_t SubLeaf, uint32_t (&Registers)[4])
+    {
+#if defined(_MSC_VER)
+        int Result[4];
+        __cpuidex(Result, static_cast<int>(Leaf), static_cast<int>(SubLeaf));
+        std::copy(Result, Result + 4, Registers);
+#else
+        __cpuid_count(Leaf, SubLeaf, Registers[0], Registers[1], Registers[2], Registers[3]);
+#endif
+    }
+
+    // Deterministic cache parameters, leaf 4 on Intel and 0x8000001D on AMD share the register layout
+    std::vector<CacheLevel> ReadCpuidCaches()
+    {
+        uint32_t Registers[4];
+        ReadCpuid(0, 0, Registers);
+        const uint32_t MaxLeaf = Registers[0];
+        ReadCpuid(0x80000000, 0, Registers);
+        const uint32_t MaxExtendedLeaf = Registers[0];
+
+        uint32_t CacheLeaf = 0;
+        if (MaxLeaf >= 4)
+        {
+            ReadCpuid(4, 0, Registers);
+            CacheLeaf = (Registers[0] & 0x1F) != 0 ? 4 : 0;
+        }
+        if (CacheLeaf == 0 && MaxExtendedLeaf >= 0x8000001D)
+        {
+            CacheLeaf = 0x8000001D;
+        }
+
+        std::vector<CacheLevel> Result;
+        if (CacheLeaf == 0)
+        {
+            return Result;
+        }
+
+        for (uint32_t SubLeaf = 0; ; ++SubLeaf)
+        {
+            ReadCpuid(CacheLeaf, SubLeaf, Registers);
+            const uint32_t Type = Registers[0] & 0x1F;
+            if (Type == 0)
+            {
+                break;
+            }
+
+            CacheLevel& Cache = Result.emplace_back();
+            Cache.Level = (Registers[0] >> 5) & 0x7;
+            Cache.Type = Type == 1 ? CacheType::Data : Type == 2 ? CacheType::Instruction : CacheType::Unified;
+            Cache.LineSize = (Registers[1] & 0xFFF) + 1;
+            Cache.Associativity = (Registers[1] >> 22) + 1;
+            Cache.NumSharingProcessors = ((Registers[0] >> 14) & 0xFFF) + 1;
+
+            const uint64_t NumPartitions = ((Registers[1] >> 12) & 0x3FF) + 1;
+            const uint64_t NumSets = static_cast<uint64_t>(Registers[2]) + 1;
+            Cache.Size = Cache.Associativity * NumPartitions * Cache.LineSize * NumSets;
+        }
+
+        return Result;
+    }
+#else
+    std::vector<CacheLevel> ReadCpuidCaches()
+    {
+        return {};
+    }
+#endif
+
+#if defined(_WIN32) || defined(_WIN64)
+    std::vector<CacheLevel> ReadSystemCaches()
+    {
+        DWORD BufferBytes = 0;
+        GetLogicalProcessorInformation(nullptr, &BufferBytes);
+        std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> Buffer(BufferBytes / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+        if (Buffer.empty() || !GetLogicalProcessorInformation(Buffer.data(), &BufferBytes))
+        {
+            return {};
+        }
+
+        // every instance of a cache has its own entry, first one of every level and type is enough
+        std::vector<CacheLevel> Result;
+        for (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION& Info : Buffer)
+        {
+            if (Info.Relationship != RelationCache || Info.Cache.Type == CacheTrace)
+            {
+                continue;
+            }
+
+            CacheLevel Cache;
+            Cache.Level = Info.Cache.Level;
+            Cache.Type = Info.Cache.Type == CacheData ? CacheType::Data : Info.Cache.Type == CacheInstruction ? CacheType::Instruction : CacheType::Unified;
+            Cache.Size = Info.Cache.Size;
+            Cache.LineSize = Info.Cache.LineSize;
+            Cache.Associativity = Info.Cache.Associativity == CACHE_FULLY_ASSOCIATIVE ? Info.Cache.Size / Info.Cache.LineSize : Info.Cache.Associativity;
+            Cache.NumSharingProcessors = std::popcount(static_cast<uint64_t>(Info.ProcessorMask));
+
+            const bool bKnown = std::any_of(Result.begin(), Result.end(), [&Cache](const CacheLevel& Other)
+            {
+                return Other.Level == Cache.Level && Other.Type == Cache.Type;
+            });
+            if (!bKnown)
+            {
+                Result.push_back(Cache);
+            }
+        }
+
+        return Result;
+    }
+#elif defined(__APPLE__)
+    uint64_t ReadSysctl(const char* Name)
+    {
+        uint64_t Value = 0;
+        size_t Size = sizeof(Value);
+        return sysctlbyname(Name, &Value, &Size, nullptr, 0) == 0 ? Value : 0;
+    }
+
+    // sysctl gives sizes only, associativity and sharing stay unknown
+    std::vector<CacheLevel> ReadSystemCaches()
+    {
+        const uint32_t LineSize = static_cast<uint32_t>(ReadSysctl("hw.cachelinesize"));
+
+        std::vector<CacheLevel> Result;
+        const auto AddCache = [&Result, LineSize](const uint32_t Level, const CacheType Type, const char* Name)
+        {
+            const uint64_t Size = ReadSysctl(Name);
+            if (Size > 0)
+            {
+                Result.push_back({Level, Type, Size, LineSize, 0, 0});
+            }
+        };
+
+        AddCache(1, CacheType::Instruction, "hw.l1icachesize");
+        AddCache(1, CacheType::Data, "hw.l1dcachesize");
+        AddCache(2, CacheType::Unified, "hw.l2cachesize");
+        AddCache(3, CacheType::Unified, "hw.l3cachesize");
+
+        return Result;
+    }
+#else
+    bool ReadCacheFile(const std::string& Path, std::string& OutValue)
+    {
+        std::ifstream File(Path);
+        return static_cast<bool>(std::getline(File, OutValue));
+    }
+
+    // "48K", "2048K", "32M"
+    uint64_t ParseSize(const std::string& Text)
+    {
+        size_t End = 0;
+        const uint64_t Value = std::stoull(Text, &End);
+        const char Unit = End < Text.size() ? Text[End] : ' ';
+        return Unit == 'K' ? Value << 10 : Unit == 'M' ? Value << 20 : Unit == 'G' ? Value << 30 : Value;
+    }
+
+    // "0-3,8-11"
+    uint32_t CountCpus(const std::string& CpuList)
+    {
+        uint32_t Result = 0;
+        size_t Position = 0;
+        while (Position < CpuList.size())
+        {
+            size_t End = 0;
+            const uint32_t First = std::stoul(CpuList.substr(Position), &End);
+            Position += End;
+
+            uint32_t Last = First;
+            if (Position < CpuList.size() && CpuList[Position] == '-')
+            {
+                ++Position;
+                Last = std::stoul(CpuList.substr(Position), &End);
+                Position += End;
+            }
+
+            Result += Last - First + 1;
+            ++Position;
+        }
+
+        return Result;
+    }
+
+    std::vector<CacheLevel> ReadSystemCaches()
+    {
+        std::vector<CacheLevel> Result;
+        for (uint32_t Index = 0; ; ++Index)
+        {
+            const std::string Directory = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(Index) + "/";
+
+            std::string Level;
+            std::string Type;
+            std::string Size;
+            if (!ReadCacheFile(Directory + "level", Level) || !ReadCacheFile(Directory + "type", Type) || !ReadCacheFile(Directory + "size", Size))
+            {
+                break;
+            }
+
+            CacheLevel& Cache = Result.emplace_back();
+            Cache.Level = std::stoul(Level);
+            Cache.Type = Type == "Data" ? CacheType::Data : Type == "Instruction" ? CacheType::Instruction : CacheType::Unified;
+            Cache.Size = ParseSize(Size);
+
+            // some kernels and virtual machines leave these out
+            std::string Value;
+            if (ReadCacheFile(Directory + "coherency_line_size", Value))
+            {
+                Cache.LineSize = std::stoul(Value);
+            }
+            if (ReadCacheFile(Directory + "ways_of_associativity", Value))
+            {
+                Cache.Associativity = std::stoul(Value);
+            }
+            if (ReadCacheFile(Directory + "shared_cpu_list", Value))
+            {
+                Cache.NumSharingProcessors = CountCpus(Value);
+            }
+        }
+
+        return Result;
+    }
+#endif
+
+    std::vector<CacheLevel> DetectCaches()
+    {
+        std::vector<CacheLevel> Result;
+        try
+        {
+            Result = ReadSystemCaches();
+        }
+        catch (const std::exception&)
+        {
+            // malformed system files, CPUID still knows the caches
+            Result.clear();
+        }
+
+        if (Result.empty())
+        {
+            Result = ReadCpuidCaches();
+        }
+
+        std::sort(Result.begin(), Result.end(), [](const CacheLevel& Left, const CacheLevel& Right)
+        {
+            return Left.Level != Right.Level ? Left.Level < Right.Level : Left.Type > Right.Type;
+        });
+
+        return Result;
+    }
+
+    const char* GetTypeName(const CacheType Type)
+    {
+        switch (Type)
+        {
+        case CacheType::Data:
+            return "data";
+        case CacheType::Instruction:
+            return "instruction";
+        default:
+            return "unified";
+        }
+    }
+}
+
+const std::vector<CacheLevel>& CacheTopology::GetCaches()
+{
+    static const std::vector<CacheLevel> Caches = DetectCaches();
+    return Caches;
+}
+
+const CacheLevel* CacheTopology::FindDataCache(const uint32_t Level)
+{
+    for (const CacheLevel& Cache : GetCaches())
+    {
+        if (Cache.Level == Level && Cache.Type != CacheType::Instruction)
+        {
+            return &Cache;
+        }
+    }
+
+    return nullptr;
+}
+
+uint64_t CacheTopology::GetDataCacheSize(const uint32_t Level)
+{
+    const CacheLevel* Cache = FindDataCache(Level);
+    return Cache != nullptr ? Cache->Size : 0;
+}
+
+uint32_t CacheTopology::GetCacheLineSize()
+{
+    const CacheLevel* Cache = FindDataCache(1);
+    return Cache != nullptr && Cache->LineSize > 0 ? Cache->LineSize : DefaultCacheLineSize;
+}
+
+void CacheTopology::Print()
+{
+    if (GetCaches().empty())
+    {
+        std::printf("cache topology: not detected\n");
+        return;
+    }
+
+    for (const CacheLevel& Cache : GetCaches())
+    {
+        std::printf("L%u %s: %.1f KiB, line %u B, %u-way, shared by %u logical processors\n", Cache.Level, GetTypeName(Cache.Type),
+                    static_cast<double>(Cache.Size) / 1024., Cache.LineSize, Cache.Associativity, Cache.NumSharingProcessors);
+    }
+}
@@ -0,0 +1,60 @@
+#include "CycleCounter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace
+{
+    double CalibrateNanosecondsPerCycle()
+    {
+        constexpr std::chrono::milliseconds CalibrationTime(20);
+
+        const auto TimeStart = std::chrono::steady_clock::now();
+        const uint64_t CyclesStart = CycleCounter::Now();
+
+        std::chrono::steady_clock::time_point TimeEnd;
+        do
+        {
+            TimeEnd = std::chrono::steady_clock::now();
+        }
+        while (TimeEnd - TimeStart < CalibrationTime);
+
+        const uint64_t CyclesEnd = CycleCounter::Now();
+
+        const double Nanoseconds = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(TimeEnd - TimeStart).count());
+        return Nanoseconds / static_cast<double>(CyclesEnd - CyclesStart);
+    }
+
+    uint64_t MeasureOverheadCycles()
+    {
+        constexpr uint32_t NumSamples = 10000;
+
+        uint64_t Result = std::numeric_limits<uint64_t>::max();
+        for (uint32_t SampleIndex = 0; SampleIndex < NumSamples; ++SampleIndex)
+        {
+            const uint64_t Start = CycleCounter::Now();
+            const uint64_t End = CycleCounter::Now();
+            Result = std::min(Result, End - Start);
+        }
+
+        return Result;
+    }
+}
+
+double CycleCounter::GetNanosecondsPerCycle()
+{
+    static const double NanosecondsPerCycle = CalibrateNanosecondsPerCycle();
+    return NanosecondsPerCycle;
+}
+
+uint64_t CycleCounter::GetOverheadCycles()
+{
+    static const uint64_t OverheadCycles = MeasureOverheadCycles();
+    return OverheadCycles;
+}
+
+double CycleCounter::ToNanoseconds(const uint64_t Cycles)
+{
+    return static_cast<double>(Cycles) * GetNanosecondsPerCycle();
+}
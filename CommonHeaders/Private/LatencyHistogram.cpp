@@ -0,0 +1,89 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+
+#include "CycleCounter.h"
+
+void LatencyHistogram::Record(const uint64_t Cycles)
+{
+    ++Buckets[GetBucketIndex(Cycles)];
+    ++Count;
+    Total += Cycles;
+    Max = std::max(Max, Cycles);
+}
+
+void LatencyHistogram::RecordInterval(const uint64_t StartCycles, const uint64_t EndCycles, const uint64_t OverheadCycles)
+{
+    const uint64_t Cycles = EndCycles - StartCycles;
+    Record(Cycles > OverheadCycles ? Cycles - OverheadCycles : 0);
+}
+
+uint64_t LatencyHistogram::GetPercentile(const double Percentile) const
+{
+    if (Count == 0)
+    {
+        return 0;
+    }
+
+    const uint64_t TargetCount = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(Percentile / 100. * static_cast<double>(Count))), 1);
+
+    uint64_t CumulativeCount = 0;
+    for (uint32_t BucketIndex = 0; BucketIndex < NumBuckets; ++BucketIndex)
+    {
+        CumulativeCount += Buckets[BucketIndex];
+        if (CumulativeCount >= TargetCount)
+        {
+            return std::min(GetBucketHighestValue(BucketIndex), Max);
+        }
+    }
+
+    return Max;
+}
+
+double LatencyHistogram::GetTotalMilliseconds() const
+{
+    return CycleCounter::ToNanoseconds(Total) * 1e-6;
+}
+
+std::string LatencyHistogram::ToString() const
+{
+    char Buffer[128];
+    std::snprintf(Buffer, sizeof(Buffer), "total %fms, p50 %.1fns, p99 %.1fns, p99.9 %.1fns, max %.1fns", GetTotalMilliseconds(),
+                  CycleCounter::ToNanoseconds(GetPercentile(50.)), CycleCounter::ToNanoseconds(GetPercentile(99.)),
+                  CycleCounter::ToNanoseconds(GetPercentile(99.9)), CycleCounter::ToNanoseconds(Max));
+
+    return Buffer;
+}
+
+void LatencyHistogram::Print(const char* Name) const
+{
+    std::printf("%s: %s\n", Name, ToString().c_str());
+}
+
+uint32_t LatencyHistogram::GetBucketIndex(const uint64_t Cycles)
+{
+    // first two rows map values one to one
+    if (Cycles < 2 * NumSubBuckets)
+    {
+        return static_cast<uint32_t>(Cycles);
+    }
+
+    // value keeps its SubBucketBits + 1 highest bits, the top one is implied by the row
+    const uint32_t Shift = std::bit_width(Cycles) - SubBucketBits - 1;
+    return (Shift + 1) * NumSubBuckets + static_cast<uint32_t>((Cycles >> Shift) - NumSubBuckets);
+}
+
+uint64_t LatencyHistogram::GetBucketHighestValue(const uint32_t BucketIndex)
+{
+    if (BucketIndex < 2 * NumSubBuckets)
+    {
+        return BucketIndex;
+    }
+
+    const uint32_t Shift = BucketIndex / NumSubBuckets - 1;
+    const uint64_t Lowest = static_cast<uint64_t>(NumSubBuckets + BucketIndex % NumSubBuckets) << Shift;
+    return Lowest + ((1llu << Shift) - 1);
+}
@@ -0,0 +1,237 @@
+#include "PageBuffer.h"
+
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+#include <utility>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+    uint64_t RoundUp(const uint64_t Value, const uint64_t Alignment)
+    {
+        return (Value + Alignment - 1) / Alignment * Alignment;
+    }
+
+#if defined(__linux__)
+    uint64_t ReadUint64(const char* Path)
+    {
+        std::ifstream File(Path);
+        uint64_t Value = 0;
+        File >> Value;
+        return File ? Value : 0;
+    }
+
+    // "always [madvise] never", the selected mode is in brackets
+    bool AreTransparentHugePagesEnabled()
+    {
+        std::ifstream File("/sys/kernel/mm/transparent_hugepage/enabled");
+        std::string Modes;
+        std::getline(File, Modes);
+        return !Modes.empty() && Modes.find("[never]") == std::string::npos;
+    }
+
+    // AnonHugePages of every mapping overlapping [Begin, End)
+    uint64_t ReadAnonHugePages(const uintptr_t Begin, const uintptr_t End)
+    {
+        std::ifstream File("/proc/self/smaps");
+        uint64_t Result = 0;
+        bool bOverlaps = false;
+
+        std::string Line;
+        while (std::getline(File, Line))
+        {
+            // mapping header: "start-end perms offset device inode path"
+            const size_t Dash = Line.find('-');
+            const size_t Space = Line.find(' ');
+            if (Dash != std::string::npos && Space != std::string::npos && Dash < Space && Line.find(':') > Space)
+            {
+                const uintptr_t MappingBegin = std::stoull(Line.substr(0, Dash), nullptr, 16);
+                const uintptr_t MappingEnd = std::stoull(Line.substr(Dash + 1, Space - Dash - 1), nullptr, 16);
+                bOverlaps = MappingBegin < End && Begin < MappingEnd;
+            }
+            else if (bOverlaps && Line.starts_with("AnonHugePages:"))
+            {
+                Result += std::stoull(Line.substr(Line.find(':') + 1)) * 1024;
+            }
+        }
+
+        return Result;
+    }
+#endif
+}
+
+PageBuffer::PageBuffer(const uint64_t InSize, const PageKind RequestedKind)
+{
+    const uint64_t HugePageSize = GetHugePageSize();
+
+#if defined(_WIN32) || defined(_WIN64)
+    // needs SeLockMemoryPrivilege, fails without it
+    if (RequestedKind != PageKind::Small && HugePageSize > 0)
+    {
+        MappingSize = RoundUp(InSize, HugePageSize);
+        Mapping = VirtualAlloc(nullptr, MappingSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        Kind = PageKind::ExplicitHuge;
+    }
+    if (Mapping == nullptr)
+    {
+        MappingSize = InSize;
+        Mapping = VirtualAlloc(nullptr, MappingSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        Kind = PageKind::Small;
+    }
+    if (Mapping == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    Data = Mapping;
+#else
+#if defined(__linux__)
+    // only succeeds when pages were reserved in /proc/sys/vm/nr_hugepages
+    if (RequestedKind == PageKind::ExplicitHuge && HugePageSize > 0)
+    {
+        MappingSize = RoundUp(InSize, HugePageSize);
+        Mapping = mmap(nullptr, MappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        Mapping = Mapping != MAP_FAILED ? Mapping : nullptr;
+        Data = Mapping;
+        Kind = PageKind::ExplicitHuge;
+    }
+    // khugepaged and the fault handler only use huge pages for aligned ranges, so the buffer starts on a huge page boundary
+    if (Mapping == nullptr && RequestedKind != PageKind::Small && HugePageSize > 0 && AreTransparentHugePagesEnabled())
+    {
+        MappingSize = RoundUp(InSize, HugePageSize) + HugePageSize;
+        Mapping = mmap(nullptr, MappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        Mapping = Mapping != MAP_FAILED ? Mapping : nullptr;
+        if (Mapping != nullptr)
+        {
+            Data = reinterpret_cast<void*>(RoundUp(reinterpret_cast<uintptr_t>(Mapping), HugePageSize));
+            Kind = madvise(Data, RoundUp(InSize, HugePageSize), MADV_HUGEPAGE) == 0 ? PageKind::TransparentHuge : PageKind::Small;
+        }
+    }
+#endif
+    if (Mapping == nullptr)
+    {
+        MappingSize = InSize;
+        Mapping = mmap(nullptr, MappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        Mapping = Mapping != MAP_FAILED ? Mapping : nullptr;
+        Data = Mapping;
+        Kind = PageKind::Small;
+#if defined(__linux__)
+        // with transparent huge pages set to "always" the kernel would back even this mapping with huge pages
+        if (Mapping != nullptr)
+        {
+            madvise(Mapping, MappingSize, MADV_NOHUGEPAGE);
+        }
+#endif
+    }
+    if (Mapping == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+#endif
+
+    Size = InSize;
+    std::memset(Data, 0, Size);
+}
+
+PageBuffer::~PageBuffer()
+{
+    Release();
+}
+
+PageBuffer::PageBuffer(PageBuffer&& Other) noexcept
+    : Mapping(std::exchange(Other.Mapping, nullptr))
+    , MappingSize(std::exchange(Other.MappingSize, 0))
+    , Data(std::exchange(Other.Data, nullptr))
+    , Size(std::exchange(Other.Size, 0))
+    , Kind(std::exchange(Other.Kind, PageKind::Small))
+{
+}
+
+PageBuffer& PageBuffer::operator=(PageBuffer&& Other) noexcept
+{
+    if (this != &Other)
+    {
+        Release();
+        Mapping = std::exchange(Other.Mapping, nullptr);
+        MappingSize = std::exchange(Other.MappingSize, 0);
+        Data = std::exchange(Other.Data, nullptr);
+        Size = std::exchange(Other.Size, 0);
+        Kind = std::exchange(Other.Kind, PageKind::Small);
+    }
+
+    return *this;
+}
+
+void PageBuffer::Release()
+{
+    if (Mapping == nullptr)
+    {
+        return;
+    }
+
+#if defined(_WIN32) || defined(_WIN64)
+    VirtualFree(Mapping, 0, MEM_RELEASE);
+#else
+    munmap(Mapping, MappingSize);
+#endif
+    Mapping = nullptr;
+    MappingSize = 0;
+    Data = nullptr;
+    Size = 0;
+}
+
+uint64_t PageBuffer::GetHugePageBytes() const
+{
+    if (Kind == PageKind::ExplicitHuge)
+    {
+        return Size;
+    }
+
+    // small page buffers are read too, the kernel may back them with huge pages when MADV_NOHUGEPAGE is ignored
+#if defined(__linux__)
+    if (Data != nullptr)
+    {
+        const uint64_t HugePageBytes = ReadAnonHugePages(reinterpret_cast<uintptr_t>(Data), reinterpret_cast<uintptr_t>(Data) + Size);
+        return HugePageBytes < Size ? HugePageBytes : Size;
+    }
+#endif
+
+    return 0;
+}
+
+uint64_t PageBuffer::GetHugePageSize()
+{
+#if defined(_WIN32) || defined(_WIN64)
+    return GetLargePageMinimum();
+#elif defined(__linux__)
+    static const uint64_t HugePageSize = []()
+    {
+        const uint64_t TransparentSize = ReadUint64("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size");
+        return TransparentSize > 0 ? TransparentSize : uint64_t{2} << 20;
+    }();
+    return HugePageSize;
+#else
+    return 0;
+#endif
+}
+
+const char* PageBuffer::ToString(const PageKind Kind)
+{
+    switch (Kind)
+    {
+    case PageKind::Small:
+        return "small pages";
+    case PageKind::TransparentHuge:
+        return "transparent huge pages";
+    case PageKind::ExplicitHuge:
+        return "explicit huge pages";
+    }
+
+    return "unknown";
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+
+struct AllocationStats
+{
+    uint64_t NumAllocations = 0;
+    uint64_t NumDeallocations = 0;
+    uint64_t BytesRequested = 0;
+    uint64_t LiveBytes = 0;
+    uint64_t PeakLiveBytes = 0;
+
+    void RecordAllocation(uint64_t Bytes);
+    void RecordDeallocation(uint64_t Bytes);
+
+    [[nodiscard]] double GetMeanAllocationSize() const;
+
+    // allocation and deallocation count, bytes requested, peak live bytes and mean allocation size on one line
+    [[nodiscard]] std::string ToString() const;
+};
+
+// Counts every global operator new and delete. The replacement operators are in the CommonHeaders_AllocationHook
+// object library, only programs linking it pay for the counting, without it these functions don't link.
+// Counters are atomic, so threads can allocate, but allocations of all threads end up in the same numbers.
+namespace AllocationCounter
+{
+    // Starts a new measurement, blocks allocated before keep their bytes out of live and peak live bytes
+    void Reset();
+
+    // Allocations since the last Reset
+    AllocationStats GetStats();
+}
+
+// Allocator which counts allocations of a single container into Stats, rebound copies share the same Stats.
+// Useful when several containers are measured at once and global counters can't tell them apart.
+template <typename T>
+class CountingAllocator
+{
+public:
+    using value_type = T;
+
+    explicit CountingAllocator(AllocationStats& InStats)
+        : Stats(&InStats)
+    {
+    }
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& Other)
+        : Stats(Other.Stats)
+    {
+    }
+
+    T* allocate(const size_t Count)
+    {
+        Stats->RecordAllocation(Count * sizeof(T));
+        return std::allocator<T>().allocate(Count);
+    }
+
+    void deallocate(T* Pointer, const size_t Count)
+    {
+        Stats->RecordDeallocation(Count * sizeof(T));
+        std::allocator<T>().deallocate(Pointer, Count);
+    }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U>& Other) const
+    {
+        return Stats == Other.Stats;
+    }
+
+private:
+    template <typename U>
+    friend class CountingAllocator;
+
+    AllocationStats* Stats;
+};
+
+// Memory resource counterpart of CountingAllocator, counts requests to Upstream made through this resource
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    CountingResource(AllocationStats& InStats, std::pmr::memory_resource* InUpstream)
+        : Stats(&InStats)
+        , Upstream(InUpstream)
+    {
+    }
+
+protected:
+    void* do_allocate(size_t Bytes, size_t Alignment) override;
+    void do_deallocate(void* Pointer, size_t Bytes, size_t Alignment) override;
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& Other) const noexcept override;
+
+private:
+    AllocationStats* Stats;
+    std::pmr::memory_resource* Upstream;
+};
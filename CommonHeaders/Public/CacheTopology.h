@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+enum class CacheType : uint8_t
+{
+    Data,
+    Instruction,
+    Unified
+};
+
+struct CacheLevel
+{
+    uint32_t Level = 0;
+    CacheType Type = CacheType::Unified;
+    uint64_t Size = 0;
+    uint32_t LineSize = 0;
+    // 0 when unknown, fully associative caches report their number of lines
+    uint32_t Associativity = 0;
+    // logical processors sharing one instance of this cache, 0 when unknown
+    uint32_t NumSharingProcessors = 0;
+};
+
+// Caches of the processor running the program, read from sysfs on Linux, GetLogicalProcessorInformation on Windows
+// and sysctl on macOS, with CPUID leaf 4 (0x8000001D on AMD) as fallback. Detected once on first use, never spawns a process.
+class CacheTopology {
+public:
+    // Sorted by level, instruction caches before data ones
+    [[nodiscard]] static const std::vector<CacheLevel>& GetCaches();
+
+    // Data or unified cache of Level, nullptr when not detected
+    [[nodiscard]] static const CacheLevel* FindDataCache(uint32_t Level);
+
+    // Size in bytes of data or unified cache of Level, 0 when not detected
+    [[nodiscard]] static uint64_t GetDataCacheSize(uint32_t Level);
+
+    // Line size of the first data cache, 64 when not detected
+    [[nodiscard]] static uint32_t GetCacheLineSize();
+
+    // One line per cache
+    static void Print();
+};
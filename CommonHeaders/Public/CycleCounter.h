@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+// Time stamp counter reads, cheap enough to wrap a single container operation.
+// rdtsc isn't serializing, so the result is accurate to tens of cycles, which is fine for latency distributions.
+class CycleCounter {
+public:
+    static uint64_t Now()
+    {
+        return __rdtsc();
+    }
+
+    // Calibrated against steady_clock on first use
+    [[nodiscard]] static double GetNanosecondsPerCycle();
+
+    // Smallest number of cycles between two back to back reads, subtract it from every measurement
+    [[nodiscard]] static uint64_t GetOverheadCycles();
+
+    [[nodiscard]] static double ToNanoseconds(uint64_t Cycles);
+};
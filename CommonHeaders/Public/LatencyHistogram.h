@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Log-linear histogram (HDR style) of latencies in cycles.
+// Every power of two range is split into NumSubBuckets equal buckets, so the relative error stays below 1 / NumSubBuckets
+// for any value, while the whole 64-bit range takes a few thousand counters. Values below 2 * NumSubBuckets are exact.
+class LatencyHistogram {
+public:
+    static constexpr uint32_t SubBucketBits = 5;
+    static constexpr uint32_t NumSubBuckets = 1 << SubBucketBits;
+
+    void Record(uint64_t Cycles);
+
+    // Measurement minus timer overhead, clamped to zero
+    void RecordInterval(uint64_t StartCycles, uint64_t EndCycles, uint64_t OverheadCycles);
+
+    // Highest value equivalent to the value at Percentile (0 - 100) of recorded values
+    [[nodiscard]] uint64_t GetPercentile(double Percentile) const;
+
+    [[nodiscard]] uint64_t GetCount() const
+    {
+        return Count;
+    }
+
+    [[nodiscard]] uint64_t GetTotal() const
+    {
+        return Total;
+    }
+
+    [[nodiscard]] uint64_t GetMax() const
+    {
+        return Max;
+    }
+
+    [[nodiscard]] double GetTotalMilliseconds() const;
+
+    // total in milliseconds and p50, p99, p99.9, max in nanoseconds
+    [[nodiscard]] std::string ToString() const;
+
+    // ToString on one line after Name
+    void Print(const char* Name) const;
+
+private:
+    static constexpr uint32_t NumBuckets = (64 - SubBucketBits + 1) * NumSubBuckets;
+
+    static uint32_t GetBucketIndex(uint64_t Cycles);
+    static uint64_t GetBucketHighestValue(uint32_t BucketIndex);
+
+    std::array<uint64_t, NumBuckets> Buckets{};
+    uint64_t Count = 0;
+    uint64_t Total = 0;
+    uint64_t Max = 0;
+};
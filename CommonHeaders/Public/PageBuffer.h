@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+enum class PageKind : uint8_t
+{
+    // default pages of the system, 4 KiB on x86, MADV_NOHUGEPAGE on Linux keeps transparent huge pages away
+    Small,
+    // madvise(MADV_HUGEPAGE) on Linux, the kernel may still back parts of the buffer with small pages
+    TransparentHuge,
+    // pages reserved up front, MAP_HUGETLB on Linux and MEM_LARGE_PAGES on Windows
+    ExplicitHuge
+};
+
+// Anonymous memory mapped straight from the system on the requested page size, for experiments that need to tell
+// TLB misses from cache misses. Explicit huge pages fall back to transparent ones and those to small pages when
+// the system doesn't provide them, GetPageKind tells what was used. Every page is touched when allocated,
+// so page faults aren't timed by the first pass over the buffer.
+class PageBuffer {
+public:
+    PageBuffer() = default;
+    PageBuffer(uint64_t InSize, PageKind RequestedKind);
+    ~PageBuffer();
+
+    PageBuffer(const PageBuffer&) = delete;
+    PageBuffer& operator=(const PageBuffer&) = delete;
+    PageBuffer(PageBuffer&& Other) noexcept;
+    PageBuffer& operator=(PageBuffer&& Other) noexcept;
+
+    [[nodiscard]] void* GetData() const
+    {
+        return Data;
+    }
+
+    [[nodiscard]] uint64_t GetSize() const
+    {
+        return Size;
+    }
+
+    [[nodiscard]] PageKind GetPageKind() const
+    {
+        return Kind;
+    }
+
+    // Bytes of the buffer the system backs with huge pages. Anything but explicit huge pages is read from /proc/self/smaps,
+    // so this is lower than GetSize when the kernel couldn't find free 2 MiB ranges, and above 0 for small pages it ignored.
+    [[nodiscard]] uint64_t GetHugePageBytes() const;
+
+    // Size of a huge page, 0 when the system has none
+    [[nodiscard]] static uint64_t GetHugePageSize();
+
+    [[nodiscard]] static const char* ToString(PageKind Kind);
+
+private:
+    void Release();
+
+    // whole mapping, transparent huge pages map one huge page more so Data can start on a huge page boundary
+    void* Mapping = nullptr;
+    uint64_t MappingSize = 0;
+    void* Data = nullptr;
+    uint64_t Size = 0;
+    PageKind Kind = PageKind::Small;
+};
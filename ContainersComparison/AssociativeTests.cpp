@@ -0,0 +1,255 @@
+#include "AssociativeTests.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AllocationCounter.h"
+#include "FlatHashMap.h"
+#include "FlatMap.h"
+#include "PerformanceCounter.h"
+
+namespace
+{
+#if !NDEBUG
+    constexpr uint64_t MaxIntegerKeys = 1e5;
+    constexpr uint64_t MaxStringKeys = 1e4;
+#else
+    constexpr uint64_t MaxIntegerKeys = 1e7;
+    constexpr uint64_t MaxStringKeys = 1e6;
+#endif
+
+    // lookups and erases are timed on a random sample, so the largest sizes don't take minutes
+    constexpr uint64_t MaxSampledOperations = 1e6;
+    // erasing single elements from sorted contiguous storage is O(n)
+    constexpr uint64_t MaxFlatMapEraseKeys = 1e4;
+
+    using MappedValue = uint64_t;
+
+    // Average time of a single operation in nanoseconds, negative when skipped
+    struct AssociativeTestResults
+    {
+        double Insert = -1.;
+        double Hit = -1.;
+        double Miss = -1.;
+        double Erase = -1.;
+        bool bCorrect = true;
+        // filling the map, peak live bytes is its memory footprint
+        AllocationStats InsertAllocations;
+    };
+
+    template <typename KeyType>
+    KeyType MakeKey(uint64_t Number);
+
+    template <>
+    uint64_t MakeKey<uint64_t>(const uint64_t Number)
+    {
+        return Number;
+    }
+
+    // long enough to live outside of small string buffer, like real identifiers
+    template <>
+    std::string MakeKey<std::string>(const uint64_t Number)
+    {
+        return "key_" + std::to_string(Number);
+    }
+
+    template <typename KeyType>
+    struct TestKeys
+    {
+        std::vector<KeyType> Inserted;
+        // random samples of inserted keys and keys which were never inserted
+        std::vector<KeyType> Present;
+        std::vector<KeyType> Missing;
+    };
+
+    template <typename KeyType>
+    TestKeys<KeyType> MakeTestKeys(const uint64_t NumKeys)
+    {
+        std::mt19937_64 RandomGenerator(NumKeys);
+        const uint64_t NumSamples = std::min(NumKeys, MaxSampledOperations);
+
+        // inserted numbers are even and missing ones odd, so the sets never overlap
+        std::vector<uint64_t> Numbers(NumKeys);
+        for (uint64_t& Number : Numbers)
+        {
+            Number = RandomGenerator() & ~1llu;
+        }
+        std::sort(Numbers.begin(), Numbers.end());
+        Numbers.erase(std::unique(Numbers.begin(), Numbers.end()), Numbers.end());
+        std::shuffle(Numbers.begin(), Numbers.end(), RandomGenerator);
+
+        TestKeys<KeyType> Result;
+        Result.Inserted.reserve(Numbers.size());
+        for (const uint64_t Number : Numbers)
+        {
+            Result.Inserted.push_back(MakeKey<KeyType>(Number));
+        }
+
+        std::uniform_int_distribution<uint64_t> IndexDistribution(0, Numbers.size() - 1);
+        for (uint64_t SampleIndex = 0; SampleIndex < NumSamples; ++SampleIndex)
+        {
+            Result.Present.push_back(Result.Inserted[IndexDistribution(RandomGenerator)]);
+            Result.Missing.push_back(MakeKey<KeyType>(RandomGenerator() | 1));
+        }
+
+        return Result;
+    }
+
+    // Keys differing only in their high bits, like handles with a counter in the upper half.
+    // Hash maps which take group and tag from the low bits of a weakly mixed hash put all of them into one probe sequence.
+    TestKeys<uint64_t> MakeHighBitTestKeys(const uint64_t NumKeys)
+    {
+        std::mt19937_64 RandomGenerator(NumKeys);
+        const uint64_t NumSamples = std::min(NumKeys, MaxSampledOperations);
+
+        // inserted numbers are even and missing ones odd, so the sets never overlap
+        TestKeys<uint64_t> Result;
+        Result.Inserted.reserve(NumKeys);
+        for (uint64_t KeyIndex = 0; KeyIndex < NumKeys; ++KeyIndex)
+        {
+            Result.Inserted.push_back((KeyIndex * 2) << 32);
+        }
+        std::shuffle(Result.Inserted.begin(), Result.Inserted.end(), RandomGenerator);
+
+        std::uniform_int_distribution<uint64_t> IndexDistribution(0, NumKeys - 1);
+        for (uint64_t SampleIndex = 0; SampleIndex < NumSamples; ++SampleIndex)
+        {
+            Result.Present.push_back(Result.Inserted[IndexDistribution(RandomGenerator)]);
+            Result.Missing.push_back((IndexDistribution(RandomGenerator) * 2 + 1) << 32);
+        }
+
+        return Result;
+    }
+
+    template <typename MapType>
+    constexpr bool IsFlatMap = std::is_same_v<MapType, FlatMap<typename MapType::key_type, typename MapType::mapped_type>>;
+
+    template <typename MapType>
+    AssociativeTestResults TestAssociative(const TestKeys<typename MapType::key_type>& Keys)
+    {
+        AssociativeTestResults Result;
+        PerformanceCounter PerfCounter;
+        MapType Map;
+
+        if constexpr (IsFlatMap<MapType>)
+        {
+            // one element at a time would be O(n^2), flat maps are built from a whole range
+            std::vector<std::pair<typename MapType::key_type, MappedValue>> Items;
+            Items.reserve(Keys.Inserted.size());
+            for (uint64_t KeyIndex = 0; KeyIndex < Keys.Inserted.size(); ++KeyIndex)
+            {
+                Items.emplace_back(Keys.Inserted[KeyIndex], KeyIndex);
+            }
+
+            AllocationCounter::Reset();
+            PerfCounter.Reset();
+            Map.insert(Items.begin(), Items.end());
+            Result.Insert = PerfCounter.Elapsed() * 1e6 / Keys.Inserted.size();
+            Result.InsertAllocations = AllocationCounter::GetStats();
+        }
+        else
+        {
+            AllocationCounter::Reset();
+            PerfCounter.Reset();
+            for (uint64_t KeyIndex = 0; KeyIndex < Keys.Inserted.size(); ++KeyIndex)
+            {
+                Map.emplace(Keys.Inserted[KeyIndex], KeyIndex);
+            }
+            Result.Insert = PerfCounter.Elapsed() * 1e6 / Keys.Inserted.size();
+            Result.InsertAllocations = AllocationCounter::GetStats();
+        }
+
+        uint64_t NumFound = 0;
+        PerfCounter.Reset();
+        for (const auto& Key : Keys.Present)
+        {
+            const auto It = Map.find(Key);
+            NumFound += It != Map.end() && It->second < Keys.Inserted.size();
+        }
+        Result.Hit = PerfCounter.Elapsed() * 1e6 / Keys.Present.size();
+        Result.bCorrect &= NumFound == Keys.Present.size();
+
+        NumFound = 0;
+        PerfCounter.Reset();
+        for (const auto& Key : Keys.Missing)
+        {
+            NumFound += Map.find(Key) != Map.end();
+        }
+        Result.Miss = PerfCounter.Elapsed() * 1e6 / Keys.Missing.size();
+        Result.bCorrect &= NumFound == 0;
+
+        if (!IsFlatMap<MapType> || Keys.Inserted.size() <= MaxFlatMapEraseKeys)
+        {
+            // samples may repeat, so only the first erase of a key removes anything
+            uint64_t NumErased = 0;
+            PerfCounter.Reset();
+            for (const auto& Key : Keys.Present)
+            {
+                NumErased += Map.erase(Key);
+            }
+            Result.Erase = PerfCounter.Elapsed() * 1e6 / Keys.Present.size();
+            Result.bCorrect &= Map.size() == Keys.Inserted.size() - NumErased;
+        }
+
+        return Result;
+    }
+
+    void PrintResults(const char* MapName, const AssociativeTestResults& Results)
+    {
+        std::printf("%-20s insert: %7.1fns, hit: %7.1fns, miss: %7.1fns, ", MapName, Results.Insert, Results.Hit, Results.Miss);
+        if (Results.Erase >= 0.)
+        {
+            std::printf("erase: %7.1fns", Results.Erase);
+        }
+        else
+        {
+            std::printf("erase: skipped  ");
+        }
+        std::printf(" (correct: %s)\n", Results.bCorrect ? "True" : "False");
+        std::printf("%-20s insert %s\n", "", Results.InsertAllocations.ToString().c_str());
+    }
+
+    template <typename KeyType>
+    void RunMapTests(const char* KeyName, const TestKeys<KeyType>& Keys)
+    {
+        // payload only, node based maps add their own pointers and strings their heap buffers
+        const double PayloadKiB = static_cast<double>(Keys.Inserted.size() * sizeof(std::pair<KeyType, MappedValue>)) / 1024.;
+        std::printf("%s keys: %zu (%.1f KiB of keys and values)\n", KeyName, Keys.Inserted.size(), PayloadKiB);
+
+        PrintResults("std::map", TestAssociative<std::map<KeyType, MappedValue>>(Keys));
+        PrintResults("std::unordered_map", TestAssociative<std::unordered_map<KeyType, MappedValue>>(Keys));
+        PrintResults(bStdFlatMap ? "std::flat_map" : "sorted vector map", TestAssociative<FlatMap<KeyType, MappedValue>>(Keys));
+        PrintResults("flat hash map", TestAssociative<FlatHashMap<KeyType, MappedValue>>(Keys));
+        std::printf("\n");
+    }
+
+    template <typename KeyType>
+    void RunKeyTests(const char* KeyName, const uint64_t MaxKeys)
+    {
+        for (uint64_t NumKeys = 1000; NumKeys <= MaxKeys; NumKeys *= 10)
+        {
+            RunMapTests(KeyName, MakeTestKeys<KeyType>(NumKeys));
+        }
+    }
+
+    void RunHighBitKeyTests(const uint64_t MaxKeys)
+    {
+        for (uint64_t NumKeys = 1000; NumKeys <= MaxKeys; NumKeys *= 10)
+        {
+            RunMapTests("integer << 32", MakeHighBitTestKeys(NumKeys));
+        }
+    }
+}
+
+void RunAssociativeTests()
+{
+    RunKeyTests<uint64_t>("integer", MaxIntegerKeys);
+    RunHighBitKeyTests(MaxIntegerKeys);
+    RunKeyTests<std::string>("string", MaxStringKeys);
+}
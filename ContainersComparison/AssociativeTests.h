@@ -0,0 +1,5 @@
+#pragma once
+
+// Insert, successful and failed lookup and erase on std::map, std::unordered_map, sorted flat map and FlatHashMap,
+// with integer and string keys, for sizes from a few KiB (L1) to hundreds of MiB (DRAM).
+void RunAssociativeTests();
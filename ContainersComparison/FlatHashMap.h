@@ -0,0 +1,310 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <immintrin.h>
+
+// Open addressing hash map in the style of SwissTable. Slots are split into groups of 16, every slot has a control byte:
+// Empty, Deleted or 7 bits of the key hash. Lookup compares the whole group of control bytes with one SSE instruction
+// and touches only slots whose bits match, so most failed lookups never read a key.
+// Groups are probed with triangular steps, which visit every group when their number is a power of two.
+template <typename KeyType, typename ValueType, typename Hash = std::hash<KeyType>, typename KeyEqual = std::equal_to<KeyType>>
+class FlatHashMap
+{
+public:
+    using key_type = KeyType;
+    using mapped_type = ValueType;
+    using value_type = std::pair<KeyType, ValueType>;
+
+    class iterator
+    {
+    public:
+        iterator(FlatHashMap* InMap, const size_t InSlotIndex)
+            : Map(InMap)
+            , SlotIndex(InSlotIndex)
+        {
+        }
+
+        value_type& operator*() const
+        {
+            return Map->Slots[SlotIndex];
+        }
+
+        value_type* operator->() const
+        {
+            return &Map->Slots[SlotIndex];
+        }
+
+        iterator& operator++()
+        {
+            SlotIndex = Map->FindFullSlot(SlotIndex + 1);
+            return *this;
+        }
+
+        friend bool operator==(const iterator& Left, const iterator& Right)
+        {
+            return Left.SlotIndex == Right.SlotIndex;
+        }
+
+    private:
+        friend class FlatHashMap;
+
+        FlatHashMap* Map;
+        size_t SlotIndex;
+    };
+
+    FlatHashMap() = default;
+
+    ~FlatHashMap()
+    {
+        DestroySlots();
+    }
+
+    FlatHashMap(const FlatHashMap&) = delete;
+    FlatHashMap& operator=(const FlatHashMap&) = delete;
+
+    iterator begin()
+    {
+        return {this, FindFullSlot(0)};
+    }
+
+    iterator end()
+    {
+        return {this, Capacity};
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return Size;
+    }
+
+    iterator find(const KeyType& Key)
+    {
+        if (Capacity == 0)
+        {
+            return end();
+        }
+
+        const uint64_t KeyHash = HashKey(Key);
+        const __m128i Tag = _mm_set1_epi8(GetTag(KeyHash));
+        const __m128i EmptyControls = _mm_set1_epi8(Empty);
+
+        size_t GroupIndex = GetFirstGroup(KeyHash);
+        for (size_t Step = 1; ; ++Step)
+        {
+            const __m128i Controls = LoadGroup(GroupIndex);
+            for (uint32_t Matches = _mm_movemask_epi8(_mm_cmpeq_epi8(Controls, Tag)); Matches != 0; Matches &= Matches - 1)
+            {
+                const size_t SlotIndex = GroupIndex * GroupSize + std::countr_zero(Matches);
+                if (KeyEqual()(Slots[SlotIndex].first, Key))
+                {
+                    return {this, SlotIndex};
+                }
+            }
+
+            // key would have been inserted into this group
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(Controls, EmptyControls)) != 0)
+            {
+                return end();
+            }
+
+            GroupIndex = (GroupIndex + Step) & (NumGroups - 1);
+        }
+    }
+
+    template <typename InKeyType, typename InValueType>
+    std::pair<iterator, bool> emplace(InKeyType&& Key, InValueType&& Value)
+    {
+        const iterator Existing = find(Key);
+        if (Existing != end())
+        {
+            return {Existing, false};
+        }
+
+        // tombstones count against the load factor, they make probe sequences longer just like full slots
+        if ((Size + NumDeleted + 1) * MaxLoadDenominator > Capacity * MaxLoadNumerator)
+        {
+            Rehash(Size * 2 * MaxLoadDenominator >= Capacity * MaxLoadNumerator ? std::max<size_t>(Capacity * 2, GroupSize) : Capacity);
+        }
+
+        const uint64_t KeyHash = HashKey(Key);
+        const size_t SlotIndex = FindFreeSlot(KeyHash);
+        if (GetControl(SlotIndex) == Deleted)
+        {
+            --NumDeleted;
+        }
+
+        SetControl(SlotIndex, GetTag(KeyHash));
+        std::construct_at(&Slots[SlotIndex], std::forward<InKeyType>(Key), std::forward<InValueType>(Value));
+        ++Size;
+
+        return {{this, SlotIndex}, true};
+    }
+
+    size_t erase(const KeyType& Key)
+    {
+        const iterator It = find(Key);
+        if (It == end())
+        {
+            return 0;
+        }
+
+        const size_t SlotIndex = It.SlotIndex;
+        std::destroy_at(&Slots[SlotIndex]);
+        --Size;
+
+        // probing never continues past a group with an empty slot, so such group doesn't need a tombstone
+        const __m128i Controls = LoadGroup(SlotIndex / GroupSize);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(Controls, _mm_set1_epi8(Empty))) != 0)
+        {
+            SetControl(SlotIndex, Empty);
+        }
+        else
+        {
+            SetControl(SlotIndex, Deleted);
+            ++NumDeleted;
+        }
+
+        return 1;
+    }
+
+private:
+    static constexpr size_t GroupSize = 16;
+    static constexpr int8_t Empty = -128;
+    static constexpr int8_t Deleted = -2;
+
+    static constexpr size_t MaxLoadNumerator = 7;
+    static constexpr size_t MaxLoadDenominator = 8;
+
+    struct alignas(GroupSize) Group
+    {
+        int8_t Controls[GroupSize] = {Empty, Empty, Empty, Empty, Empty, Empty, Empty, Empty,
+                                      Empty, Empty, Empty, Empty, Empty, Empty, Empty, Empty};
+    };
+
+    [[nodiscard]] __m128i LoadGroup(const size_t GroupIndex) const
+    {
+        return _mm_load_si128(reinterpret_cast<const __m128i*>(Groups[GroupIndex].Controls));
+    }
+
+    // Standard library integer hashes are identity. Murmur3 finalizer makes every bit depend on every key bit,
+    // so keys differing only in their high bits still get different groups and tags.
+    static uint64_t HashKey(const KeyType& Key)
+    {
+        uint64_t KeyHash = static_cast<uint64_t>(Hash()(Key));
+        KeyHash ^= KeyHash >> 33;
+        KeyHash *= 0xFF51AFD7ED558CCDllu;
+        KeyHash ^= KeyHash >> 33;
+        KeyHash *= 0xC4CEB9FE1A85EC53llu;
+        KeyHash ^= KeyHash >> 33;
+        return KeyHash;
+    }
+
+    // top 7 bits, the group index comes from the low ones
+    static int8_t GetTag(const uint64_t KeyHash)
+    {
+        return static_cast<int8_t>(KeyHash >> 57);
+    }
+
+    [[nodiscard]] size_t GetFirstGroup(const uint64_t KeyHash) const
+    {
+        return static_cast<size_t>(KeyHash) & (NumGroups - 1);
+    }
+
+    [[nodiscard]] int8_t GetControl(const size_t SlotIndex) const
+    {
+        return Groups[SlotIndex / GroupSize].Controls[SlotIndex % GroupSize];
+    }
+
+    void SetControl(const size_t SlotIndex, const int8_t Control)
+    {
+        Groups[SlotIndex / GroupSize].Controls[SlotIndex % GroupSize] = Control;
+    }
+
+    // First empty or deleted slot on the probe sequence, full slots have the high bit clear
+    [[nodiscard]] size_t FindFreeSlot(const uint64_t KeyHash) const
+    {
+        size_t GroupIndex = GetFirstGroup(KeyHash);
+        for (size_t Step = 1; ; ++Step)
+        {
+            const uint32_t FreeSlots = _mm_movemask_epi8(LoadGroup(GroupIndex));
+            if (FreeSlots != 0)
+            {
+                return GroupIndex * GroupSize + std::countr_zero(FreeSlots);
+            }
+
+            GroupIndex = (GroupIndex + Step) & (NumGroups - 1);
+        }
+    }
+
+    [[nodiscard]] size_t FindFullSlot(size_t SlotIndex) const
+    {
+        while (SlotIndex < Capacity && GetControl(SlotIndex) < 0)
+        {
+            ++SlotIndex;
+        }
+
+        return SlotIndex;
+    }
+
+    void Rehash(const size_t NewCapacity)
+    {
+        std::vector<Group> OldGroups = std::move(Groups);
+        value_type* OldSlots = Slots;
+        const size_t OldCapacity = Capacity;
+
+        Capacity = NewCapacity;
+        NumGroups = NewCapacity / GroupSize;
+        Groups.assign(NumGroups, Group{});
+        Slots = std::allocator<value_type>().allocate(Capacity);
+        NumDeleted = 0;
+
+        for (size_t SlotIndex = 0; SlotIndex < OldCapacity; ++SlotIndex)
+        {
+            if (OldGroups[SlotIndex / GroupSize].Controls[SlotIndex % GroupSize] >= 0)
+            {
+                const uint64_t KeyHash = HashKey(OldSlots[SlotIndex].first);
+                const size_t NewSlotIndex = FindFreeSlot(KeyHash);
+
+                SetControl(NewSlotIndex, GetTag(KeyHash));
+                std::construct_at(&Slots[NewSlotIndex], std::move(OldSlots[SlotIndex]));
+                std::destroy_at(&OldSlots[SlotIndex]);
+            }
+        }
+
+        if (OldSlots != nullptr)
+        {
+            std::allocator<value_type>().deallocate(OldSlots, OldCapacity);
+        }
+    }
+
+    void DestroySlots()
+    {
+        for (size_t SlotIndex = 0; SlotIndex < Capacity; ++SlotIndex)
+        {
+            if (GetControl(SlotIndex) >= 0)
+            {
+                std::destroy_at(&Slots[SlotIndex]);
+            }
+        }
+
+        if (Slots != nullptr)
+        {
+            std::allocator<value_type>().deallocate(Slots, Capacity);
+        }
+    }
+
+    std::vector<Group> Groups;
+    value_type* Slots = nullptr;
+    size_t Capacity = 0;
+    size_t NumGroups = 0;
+    size_t Size = 0;
+    size_t NumDeleted = 0;
+};
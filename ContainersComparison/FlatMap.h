@@ -0,0 +1,98 @@
+#pragma once
+
+#include <version>
+
+// Sorted flat map: keys and values in contiguous sorted storage, binary search lookup and O(n) single element insert/erase.
+// Uses C++23 std::flat_map when the standard library has it, otherwise the minimal subset below with the same interface.
+
+#if defined(__cpp_lib_flat_map)
+
+#include <flat_map>
+
+template <typename KeyType, typename ValueType>
+using FlatMap = std::flat_map<KeyType, ValueType>;
+
+constexpr bool bStdFlatMap = true;
+
+#else
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+template <typename KeyType, typename ValueType>
+class SortedVectorMap
+{
+public:
+    using key_type = KeyType;
+    using mapped_type = ValueType;
+    using value_type = std::pair<KeyType, ValueType>;
+    using iterator = typename std::vector<value_type>::iterator;
+
+    iterator begin()
+    {
+        return Items.begin();
+    }
+
+    iterator end()
+    {
+        return Items.end();
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return Items.size();
+    }
+
+    // appends the whole range and sorts once, like std::flat_map does, first of equal keys wins
+    template <typename InputIterator>
+    void insert(InputIterator First, InputIterator Last)
+    {
+        Items.insert(Items.end(), First, Last);
+
+        std::stable_sort(Items.begin(), Items.end(), [](const value_type& Left, const value_type& Right)
+        {
+            return Left.first < Right.first;
+        });
+        Items.erase(std::unique(Items.begin(), Items.end(), [](const value_type& Left, const value_type& Right)
+        {
+            return Left.first == Right.first;
+        }), Items.end());
+    }
+
+    iterator find(const KeyType& Key)
+    {
+        const iterator It = LowerBound(Key);
+        return It != Items.end() && It->first == Key ? It : Items.end();
+    }
+
+    size_t erase(const KeyType& Key)
+    {
+        const iterator It = find(Key);
+        if (It == Items.end())
+        {
+            return 0;
+        }
+
+        Items.erase(It);
+        return 1;
+    }
+
+private:
+    iterator LowerBound(const KeyType& Key)
+    {
+        return std::lower_bound(Items.begin(), Items.end(), Key, [](const value_type& Item, const KeyType& Value)
+        {
+            return Item.first < Value;
+        });
+    }
+
+    std::vector<value_type> Items;
+};
+
+template <typename KeyType, typename ValueType>
+using FlatMap = SortedVectorMap<KeyType, ValueType>;
+
+constexpr bool bStdFlatMap = false;
+
+#endif
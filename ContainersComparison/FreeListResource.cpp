@@ -0,0 +1,92 @@
+#include "FreeListResource.h"
+
+#include <algorithm>
+
+FreeListResource::FreeListResource(const size_t InChunkSize, const size_t InMaxBlockSize, std::pmr::memory_resource* InUpstream)
+    : Upstream(InUpstream)
+    , ChunkSize(std::max(InChunkSize, InMaxBlockSize))
+    , MaxBlockSize(InMaxBlockSize)
+{
+}
+
+FreeListResource::~FreeListResource()
+{
+    for (const Chunk& UsedChunk : Chunks)
+    {
+        Upstream->deallocate(UsedChunk.Data, ChunkSize, UsedChunk.Alignment);
+    }
+}
+
+void* FreeListResource::do_allocate(const size_t Bytes, const size_t Alignment)
+{
+    SizeClass* Class = FindSizeClass(Bytes, Alignment);
+    if (Class == nullptr)
+    {
+        return Upstream->allocate(Bytes, Alignment);
+    }
+
+    if (Class->FreeBlocks != nullptr)
+    {
+        FreeBlock* Block = Class->FreeBlocks;
+        Class->FreeBlocks = Block->Next;
+        return Block;
+    }
+
+    if (Class->ChunkCursor == Class->ChunkEnd)
+    {
+        AllocateChunk(*Class);
+    }
+
+    void* Block = Class->ChunkCursor;
+    Class->ChunkCursor += Class->BlockSize;
+    return Block;
+}
+
+void FreeListResource::do_deallocate(void* Pointer, const size_t Bytes, const size_t Alignment)
+{
+    SizeClass* Class = FindSizeClass(Bytes, Alignment);
+    if (Class == nullptr)
+    {
+        Upstream->deallocate(Pointer, Bytes, Alignment);
+        return;
+    }
+
+    FreeBlock* Block = static_cast<FreeBlock*>(Pointer);
+    Block->Next = Class->FreeBlocks;
+    Class->FreeBlocks = Block;
+}
+
+bool FreeListResource::do_is_equal(const std::pmr::memory_resource& Other) const noexcept
+{
+    return this == &Other;
+}
+
+FreeListResource::SizeClass* FreeListResource::FindSizeClass(const size_t Bytes, const size_t Alignment)
+{
+    // every block has to hold the free list link and keep the next block aligned
+    const size_t BlockAlignment = std::max(Alignment, alignof(FreeBlock));
+    const size_t BlockSize = (std::max(Bytes, sizeof(FreeBlock)) + BlockAlignment - 1) / BlockAlignment * BlockAlignment;
+    if (BlockSize > MaxBlockSize)
+    {
+        return nullptr;
+    }
+
+    for (SizeClass& Class : SizeClasses)
+    {
+        if (Class.BlockSize == BlockSize && Class.BlockAlignment == BlockAlignment)
+        {
+            return &Class;
+        }
+    }
+
+    return &SizeClasses.emplace_back(SizeClass{BlockSize, BlockAlignment});
+}
+
+void FreeListResource::AllocateChunk(SizeClass& Class)
+{
+    std::byte* Data = static_cast<std::byte*>(Upstream->allocate(ChunkSize, Class.BlockAlignment));
+    Chunks.push_back({Data, Class.BlockAlignment});
+
+    Class.ChunkCursor = Data;
+    Class.ChunkEnd = Data + ChunkSize / Class.BlockSize * Class.BlockSize;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+// Intrusive free lists of equally sized blocks, one per distinct block size. Freed block keeps pointer to the next
+// free one in its own memory, so allocation and deallocation are a single pointer swap. Blocks are cut from chunks
+// of ChunkSize bytes, which go back to the upstream resource only when the resource is destroyed.
+// Node based containers ask for one or two sizes (deque map and blocks), so size classes are searched linearly.
+// Requests larger than MaxBlockSize are passed to the upstream resource.
+class FreeListResource : public std::pmr::memory_resource
+{
+public:
+    explicit FreeListResource(size_t InChunkSize = 256 * 1024, size_t InMaxBlockSize = 1024,
+                              std::pmr::memory_resource* InUpstream = std::pmr::get_default_resource());
+    ~FreeListResource() override;
+
+    FreeListResource(const FreeListResource&) = delete;
+    FreeListResource& operator=(const FreeListResource&) = delete;
+
+protected:
+    void* do_allocate(size_t Bytes, size_t Alignment) override;
+    void do_deallocate(void* Pointer, size_t Bytes, size_t Alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& Other) const noexcept override;
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* Next;
+    };
+
+    struct SizeClass
+    {
+        size_t BlockSize;
+        size_t BlockAlignment;
+        FreeBlock* FreeBlocks = nullptr;
+        // part of the newest chunk of this class which was never handed out
+        std::byte* ChunkCursor = nullptr;
+        std::byte* ChunkEnd = nullptr;
+    };
+
+    struct Chunk
+    {
+        std::byte* Data;
+        size_t Alignment;
+    };
+
+    // nullptr for requests which go to the upstream resource, creates the class on first use
+    SizeClass* FindSizeClass(size_t Bytes, size_t Alignment);
+    void AllocateChunk(SizeClass& Class);
+
+    std::pmr::memory_resource* Upstream;
+    size_t ChunkSize;
+    size_t MaxBlockSize;
+
+    std::vector<SizeClass> SizeClasses;
+    std::vector<Chunk> Chunks;
+};
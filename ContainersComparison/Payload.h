@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Container element of Size bytes. Value is written to every word, so constructing and copying touches the whole payload.
+template <size_t Size>
+struct PayloadData
+{
+    static_assert(Size >= sizeof(uint32_t) && Size % sizeof(uint32_t) == 0);
+    static constexpr size_t NumWords = Size / sizeof(uint32_t);
+
+    PayloadData() = default;
+
+    PayloadData(const uint64_t Value)
+    {
+        std::fill_n(Words, NumWords, static_cast<uint32_t>(Value));
+    }
+
+    uint32_t Words[NumWords];
+};
+
+template <size_t Size, bool bTriviallyCopyable>
+struct Payload : PayloadData<Size>
+{
+    using PayloadData<Size>::PayloadData;
+};
+
+// Same layout, but copies go through user provided members, so containers can't move elements with memmove
+template <size_t Size>
+struct Payload<Size, false> : PayloadData<Size>
+{
+    using PayloadData<Size>::PayloadData;
+
+    Payload() = default;
+
+    Payload(const Payload& Other)
+        : PayloadData<Size>()
+    {
+        std::copy_n(Other.Words, PayloadData<Size>::NumWords, this->Words);
+    }
+
+    Payload& operator=(const Payload& Other)
+    {
+        std::copy_n(Other.Words, PayloadData<Size>::NumWords, this->Words);
+        return *this;
+    }
+};
+
+static_assert(std::is_trivially_copyable_v<Payload<16, true>> && !std::is_trivially_copyable_v<Payload<16, false>>);
+static_assert(sizeof(Payload<64, true>) == 64 && sizeof(Payload<64, false>) == 64);
@@ -0,0 +1,294 @@
+#pragma once
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+// Sequence made of ChunkCapacity sized ring buffers, every chunk except the last one is full.
+// Element i lives in chunk i / ChunkCapacity, so indexing is O(1). Positional insert and erase shift elements
+// only inside one chunk and then move a single element between every following pair of chunks,
+// which is O(ChunkCapacity + size / ChunkCapacity), O(sqrt n) for chunk capacity close to sqrt n.
+// T has to be default constructible, chunks are allocated whole.
+template <typename T, uint32_t ChunkCapacity = 1024>
+class TieredVector
+{
+    static_assert(ChunkCapacity >= 2 && (ChunkCapacity & (ChunkCapacity - 1)) == 0, "ring buffer index wraps with a mask");
+
+    struct Chunk
+    {
+        T Items[ChunkCapacity];
+        uint32_t Head = 0;
+        uint32_t Size = 0;
+
+        T& At(const uint32_t Index)
+        {
+            return Items[(Head + Index) & (ChunkCapacity - 1)];
+        }
+
+        void PushFront(const T& Value)
+        {
+            Head = (Head - 1) & (ChunkCapacity - 1);
+            Items[Head] = Value;
+            ++Size;
+        }
+
+        void PushBack(const T& Value)
+        {
+            At(Size++) = Value;
+        }
+
+        T PopFront()
+        {
+            T Value = Items[Head];
+            Head = (Head + 1) & (ChunkCapacity - 1);
+            --Size;
+            return Value;
+        }
+
+        T PopBack()
+        {
+            return At(--Size);
+        }
+
+        // shifts the shorter side of the chunk, like deque does
+        void Insert(const uint32_t Index, const T& Value)
+        {
+            if (Index < Size / 2)
+            {
+                Head = (Head - 1) & (ChunkCapacity - 1);
+                for (uint32_t ItemIndex = 0; ItemIndex < Index; ++ItemIndex)
+                {
+                    At(ItemIndex) = At(ItemIndex + 1);
+                }
+            }
+            else
+            {
+                for (uint32_t ItemIndex = Size; ItemIndex > Index; --ItemIndex)
+                {
+                    At(ItemIndex) = At(ItemIndex - 1);
+                }
+            }
+
+            At(Index) = Value;
+            ++Size;
+        }
+
+        void Erase(const uint32_t Index)
+        {
+            if (Index < Size / 2)
+            {
+                for (uint32_t ItemIndex = Index; ItemIndex > 0; --ItemIndex)
+                {
+                    At(ItemIndex) = At(ItemIndex - 1);
+                }
+                Head = (Head + 1) & (ChunkCapacity - 1);
+            }
+            else
+            {
+                for (uint32_t ItemIndex = Index; ItemIndex + 1 < Size; ++ItemIndex)
+                {
+                    At(ItemIndex) = At(ItemIndex + 1);
+                }
+            }
+
+            --Size;
+        }
+    };
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using reference = T&;
+
+    class iterator
+    {
+    public:
+        using iterator_concept = std::random_access_iterator_tag;
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = ptrdiff_t;
+        using reference = T&;
+        using pointer = T*;
+
+        iterator() = default;
+
+        iterator(TieredVector* InContainer, const size_t InIndex)
+            : Container(InContainer)
+            , Index(InIndex)
+        {
+        }
+
+        T& operator*() const
+        {
+            return (*Container)[Index];
+        }
+
+        T* operator->() const
+        {
+            return &(*Container)[Index];
+        }
+
+        T& operator[](const difference_type Offset) const
+        {
+            return (*Container)[Index + Offset];
+        }
+
+        iterator& operator++()
+        {
+            ++Index;
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator Result = *this;
+            ++Index;
+            return Result;
+        }
+
+        iterator& operator--()
+        {
+            --Index;
+            return *this;
+        }
+
+        iterator operator--(int)
+        {
+            iterator Result = *this;
+            --Index;
+            return Result;
+        }
+
+        iterator& operator+=(const difference_type Offset)
+        {
+            Index += Offset;
+            return *this;
+        }
+
+        iterator& operator-=(const difference_type Offset)
+        {
+            Index -= Offset;
+            return *this;
+        }
+
+        friend iterator operator+(iterator It, const difference_type Offset)
+        {
+            return It += Offset;
+        }
+
+        friend iterator operator+(const difference_type Offset, iterator It)
+        {
+            return It += Offset;
+        }
+
+        friend iterator operator-(iterator It, const difference_type Offset)
+        {
+            return It -= Offset;
+        }
+
+        friend difference_type operator-(const iterator& Left, const iterator& Right)
+        {
+            return static_cast<difference_type>(Left.Index) - static_cast<difference_type>(Right.Index);
+        }
+
+        friend bool operator==(const iterator& Left, const iterator& Right)
+        {
+            return Left.Index == Right.Index;
+        }
+
+        friend std::strong_ordering operator<=>(const iterator& Left, const iterator& Right)
+        {
+            return Left.Index <=> Right.Index;
+        }
+
+    private:
+        friend class TieredVector;
+
+        TieredVector* Container = nullptr;
+        size_t Index = 0;
+    };
+
+    T& operator[](const size_t Index)
+    {
+        return Chunks[Index / ChunkCapacity]->At(static_cast<uint32_t>(Index % ChunkCapacity));
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return Size;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return Size == 0;
+    }
+
+    iterator begin()
+    {
+        return {this, 0};
+    }
+
+    iterator end()
+    {
+        return {this, Size};
+    }
+
+    void push_back(const T& Value)
+    {
+        if (Chunks.empty() || Chunks.back()->Size == ChunkCapacity)
+        {
+            Chunks.push_back(std::make_unique<Chunk>());
+        }
+
+        Chunks.back()->PushBack(Value);
+        ++Size;
+    }
+
+    iterator insert(const iterator Position, const T& Value)
+    {
+        if (Chunks.empty() || Chunks.back()->Size == ChunkCapacity)
+        {
+            Chunks.push_back(std::make_unique<Chunk>());
+        }
+
+        // every chunk after the target one passes its last element to the next chunk, so the target one gets a free slot
+        const size_t ChunkIndex = Position.Index / ChunkCapacity;
+        for (size_t NextChunkIndex = Chunks.size() - 1; NextChunkIndex > ChunkIndex; --NextChunkIndex)
+        {
+            Chunks[NextChunkIndex]->PushFront(Chunks[NextChunkIndex - 1]->PopBack());
+        }
+
+        Chunks[ChunkIndex]->Insert(static_cast<uint32_t>(Position.Index % ChunkCapacity), Value);
+        ++Size;
+
+        return {this, Position.Index};
+    }
+
+    iterator erase(const iterator Position)
+    {
+        const size_t ChunkIndex = Position.Index / ChunkCapacity;
+        Chunks[ChunkIndex]->Erase(static_cast<uint32_t>(Position.Index % ChunkCapacity));
+
+        // refill the hole with first elements of the following chunks
+        for (size_t NextChunkIndex = ChunkIndex + 1; NextChunkIndex < Chunks.size(); ++NextChunkIndex)
+        {
+            Chunks[NextChunkIndex - 1]->PushBack(Chunks[NextChunkIndex]->PopFront());
+        }
+
+        if (Chunks.back()->Size == 0)
+        {
+            Chunks.pop_back();
+        }
+        --Size;
+
+        return {this, Position.Index};
+    }
+
+private:
+    std::vector<std::unique_ptr<Chunk>> Chunks;
+    size_t Size = 0;
+};
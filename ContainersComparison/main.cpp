@@ -1,19 +1,36 @@
+#include <array>
 #include <bitset>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <vector>
 #include <list>
 #include <deque>
+#include <memory>
+#include <memory_resource>
 #include <random>
+#include <string>
 
+#include "AllocationCounter.h"
+#include "AssociativeTests.h"
+#include "CycleCounter.h"
+#include "LatencyHistogram.h"
 #include "PerformanceCounter.h"
+#include "FreeListResource.h"
+#include "Payload.h"
+#include "TieredVector.h"
 
 using DataBlock = uint32_t;
 constexpr uint64_t NumBlocksBig = 1e6;
 constexpr uint64_t  NumBlocksSmall = 1e4;
 
+// Tests reset allocation counters right before the timed part, so AllocationCounter::GetStats() called right after a test
+// returns allocations of the timed part only. With pmr resources that's the traffic from the resource to global new.
+
 template <typename ContainerType>
 double TestPushBack(ContainerType& Container, uint64_t NumBlocks)
 {
+    AllocationCounter::Reset();
     PerformanceCounter PerfCounter;
     PerfCounter.Reset();
 
@@ -25,31 +42,33 @@ double TestPushBack(ContainerType& Container, uint64_t NumBlocks)
     return PerfCounter.Elapsed();
 }
 
+// Per operation latencies, timer overhead is already subtracted
 struct InterleavedTestResults
 {
-    double VectorTime = 0.;
-    double ListTime = 0.;
-    double DequeTime = 0.;
+    LatencyHistogram VectorTime;
+    LatencyHistogram ListTime;
+    LatencyHistogram DequeTime;
 };
 
-InterleavedTestResults TestInterleavedPushBack(std::vector<DataBlock>& Vector, std::list<DataBlock>& List, std::deque<DataBlock>& Deque, uint64_t NumBlocks)
+template <typename VectorType, typename ListType, typename DequeType>
+InterleavedTestResults TestInterleavedPushBack(VectorType& Vector, ListType& List, DequeType& Deque, uint64_t NumBlocks)
 {
     InterleavedTestResults Result;
-    PerformanceCounter PerfConter;
+    const uint64_t OverheadCycles = CycleCounter::GetOverheadCycles();
 
     for (DataBlock sampleIndex = 0; sampleIndex < NumBlocks; ++sampleIndex)
     {
-        PerfConter.Reset();
+        uint64_t StartCycles = CycleCounter::Now();
         Vector.push_back(sampleIndex);
-        Result.VectorTime += PerfConter.Elapsed();
+        Result.VectorTime.RecordInterval(StartCycles, CycleCounter::Now(), OverheadCycles);
 
-        PerfConter.Reset();
+        StartCycles = CycleCounter::Now();
         List.push_back(sampleIndex);
-        Result.ListTime += PerfConter.Elapsed();
+        Result.ListTime.RecordInterval(StartCycles, CycleCounter::Now(), OverheadCycles);
 
-        PerfConter.Reset();
+        StartCycles = CycleCounter::Now();
         Deque.push_back(sampleIndex);
-        Result.DequeTime += PerfConter.Elapsed();
+        Result.DequeTime.RecordInterval(StartCycles, CycleCounter::Now(), OverheadCycles);
     }
 
     return Result;
@@ -57,25 +76,28 @@ InterleavedTestResults TestInterleavedPushBack(std::vector<DataBlock>& Vector, s
 
 struct InsertTestResults
 {
-    double IteratorMovement = 0.;
-    double Insert = 0.;
+    LatencyHistogram IteratorMovement;
+    LatencyHistogram Insert;
+    AllocationStats Allocations;
 };
 
 template <typename ContainerIteratorType>
 inline ContainerIteratorType MoveIterator(ContainerIteratorType ContainerBegin, size_t Index)
 {
-    return ContainerBegin + Index;
-}
-
-template <>
-inline std::list<DataBlock>::iterator MoveIterator(std::list<DataBlock>::iterator ContainerBegin, size_t Index)
-{
-    for (int i = 0; i < Index; ++i)
+    // list iterators are the same type for every allocator, so they are told apart by iterator category
+    if constexpr (std::random_access_iterator<ContainerIteratorType>)
     {
-        ++ContainerBegin;
+        return ContainerBegin + Index;
     }
+    else
+    {
+        for (int i = 0; i < Index; ++i)
+        {
+            ++ContainerBegin;
+        }
 
-    return ContainerBegin;
+        return ContainerBegin;
+    }
 }
 
 template<bool bAscending = true>
@@ -112,24 +134,26 @@ InsertTestResults TestInsert(ContainerType& Container, uint64_t NumBlocks)
     GenerateRandomIndexes(RandomNumbers, NumBlocks);
 
     InsertTestResults Result;
-    PerformanceCounter PerfCounter;
+    const uint64_t OverheadCycles = CycleCounter::GetOverheadCycles();
+    AllocationCounter::Reset();
 
     for (size_t sampleIndex = 0; sampleIndex < NumBlocks; ++sampleIndex)
     {
-        PerfCounter.Reset();
+        uint64_t StartCycles = CycleCounter::Now();
         auto It = MoveIterator(Container.begin(), RandomNumbers[sampleIndex]);
-        Result.IteratorMovement += PerfCounter.Elapsed();
+        Result.IteratorMovement.RecordInterval(StartCycles, CycleCounter::Now(), OverheadCycles);
 
-        PerfCounter.Reset();
+        StartCycles = CycleCounter::Now();
         Container.insert(It, sampleIndex);
-        Result.Insert += PerfCounter.Elapsed();
+        Result.Insert.RecordInterval(StartCycles, CycleCounter::Now(), OverheadCycles);
     }
 
+    Result.Allocations = AllocationCounter::GetStats();
     return Result;
 }
 
 template <typename ContainerType>
-double TestErase(ContainerType& Container, uint64_t NumBlocks)
+LatencyHistogram TestErase(ContainerType& Container, uint64_t NumBlocks)
 {
     std::vector<size_t> RandomNumbers;
     GenerateRandomIndexes<false>(RandomNumbers, NumBlocks);
@@ -139,43 +163,265 @@ double TestErase(ContainerType& Container, uint64_t NumBlocks)
         Container.push_back(sampleIndex);
     }
 
-    double Result = 0.;
-    PerformanceCounter PerfCounter;
+    LatencyHistogram Result;
+    const uint64_t OverheadCycles = CycleCounter::GetOverheadCycles();
+    AllocationCounter::Reset();
 
     for (size_t sampleIndex = 0; sampleIndex < NumBlocks; ++sampleIndex)
     {
         auto It = MoveIterator(Container.begin(), RandomNumbers[sampleIndex]);
-        PerfCounter.Reset();
+        const uint64_t StartCycles = CycleCounter::Now();
         Container.erase(It);
-        Result += PerfCounter.Elapsed();
+        Result.RecordInterval(StartCycles, CycleCounter::Now(), OverheadCycles);
+    }
+
+    return Result;
+}
+
+// Memory resources compared with the default allocator, every test gets fresh ones
+struct ResourceVariant
+{
+    const char* Name;
+    std::unique_ptr<std::pmr::memory_resource> Resource;
+};
+
+std::vector<ResourceVariant> MakeResourceVariants()
+{
+    std::vector<ResourceVariant> Result;
+    Result.push_back({"monotonic", std::make_unique<std::pmr::monotonic_buffer_resource>()});
+    Result.push_back({"pool", std::make_unique<std::pmr::unsynchronized_pool_resource>()});
+    Result.push_back({"free list", std::make_unique<FreeListResource>()});
+
+    return Result;
+}
+
+std::string GetVariantName(const char* ContainerName, const char* VariantName)
+{
+    return std::string(ContainerName) + " (" + VariantName + ")";
+}
+
+void PrintResult(const char* Name, const double Time, const AllocationStats& Allocations)
+{
+    std::printf("%s: %fms, %s\n", Name, Time, Allocations.ToString().c_str());
+}
+
+void PrintResult(const char* Name, const LatencyHistogram& Time, const AllocationStats& Allocations)
+{
+    std::printf("%s: %s, %s\n", Name, Time.ToString().c_str(), Allocations.ToString().c_str());
+}
+
+// Part of the list-vs-vector gap which goes away with the fastest allocator is allocator cost, the rest is pointer chasing.
+void PrintGapBreakdown(const char* TestName, const double VectorTime, const double ListTime, const double BestListTime)
+{
+    std::printf("%s list-vs-vector gap: %fms, allocator: %fms, pointer chasing: %fms\n", TestName, ListTime - VectorTime,
+                ListTime - BestListTime, BestListTime - VectorTime);
+}
+
+// Element counts grow by sqrt(10) from SweepMinBlocks to SweepMaxBlocks
+constexpr uint64_t SweepMinBlocks = 1e2;
+constexpr uint64_t SweepMaxBlocks = 1e7;
+// positional operations are O(n) per operation for standard containers, larger sizes would take hours
+constexpr uint64_t SweepMaxPositionalBlocks = NumBlocksSmall;
+// larger containers are skipped, so the biggest payloads fit in memory
+constexpr uint64_t SweepMaxBytes = 512llu << 20;
+// small sizes are repeated until at least this many elements are processed, so timer resolution doesn't matter
+constexpr uint64_t SweepMinBlocksPerSample = 1e5;
+
+constexpr const char* SweepCsvPath = "ContainersComparisonSweep.csv";
+
+std::vector<uint64_t> MakeSweepCounts()
+{
+    std::vector<uint64_t> Result;
+    for (double Count = SweepMinBlocks; Count <= SweepMaxBlocks * 1.01; Count *= std::sqrt(10.))
+    {
+        Result.push_back(std::llround(Count));
     }
 
     return Result;
 }
 
+struct SweepPoint
+{
+    double Time = 0.;
+    // allocations of a single repetition
+    AllocationStats Allocations;
+};
+
+// Average time of Test in milliseconds, every repetition gets a fresh container
+template <typename ContainerType, typename TestFunction>
+SweepPoint MeasureSweepPoint(const TestFunction& Test, const uint64_t NumBlocks)
+{
+    const uint64_t NumRepeats = std::max<uint64_t>(SweepMinBlocksPerSample / NumBlocks, 1);
+
+    SweepPoint Result;
+    for (uint64_t RepeatId = 0; RepeatId < NumRepeats; ++RepeatId)
+    {
+        ContainerType Container;
+        Result.Time += Test(Container, NumBlocks);
+        Result.Allocations = AllocationCounter::GetStats();
+    }
+
+    Result.Time /= NumRepeats;
+    return Result;
+}
+
+template <typename ElementType, typename TestFunction>
+uint32_t WriteSweepRows(std::FILE* File, const char* TestName, const uint64_t MaxBlocks, const TestFunction& Test)
+{
+    constexpr const char* ContainerNames[] = {"vector", "list", "deque", "tiered vector"};
+
+    uint32_t NumRows = 0;
+    for (const uint64_t NumBlocks : MakeSweepCounts())
+    {
+        if (NumBlocks > MaxBlocks || NumBlocks * sizeof(ElementType) > SweepMaxBytes)
+        {
+            continue;
+        }
+
+        const std::array<SweepPoint, std::size(ContainerNames)> Points = {
+            MeasureSweepPoint<std::vector<ElementType>>(Test, NumBlocks),
+            MeasureSweepPoint<std::list<ElementType>>(Test, NumBlocks),
+            MeasureSweepPoint<std::deque<ElementType>>(Test, NumBlocks),
+            MeasureSweepPoint<TieredVector<ElementType>>(Test, NumBlocks),
+        };
+        const size_t WinnerIndex = std::min_element(Points.begin(), Points.end(), [](const SweepPoint& Left, const SweepPoint& Right)
+        {
+            return Left.Time < Right.Time;
+        }) - Points.begin();
+
+        std::fprintf(File, "%s,%zu,%s,%llu", TestName, sizeof(ElementType), std::is_trivially_copyable_v<ElementType> ? "true" : "false", NumBlocks);
+        for (const SweepPoint& Point : Points)
+        {
+            std::fprintf(File, ",%f", Point.Time);
+        }
+        for (const SweepPoint& Point : Points)
+        {
+            std::fprintf(File, ",%llu,%llu", static_cast<unsigned long long>(Point.Allocations.NumAllocations),
+                         static_cast<unsigned long long>(Point.Allocations.PeakLiveBytes));
+        }
+        std::fprintf(File, ",%s\n", ContainerNames[WinnerIndex]);
+        ++NumRows;
+    }
+
+    return NumRows;
+}
+
+template <typename ElementType>
+uint32_t WritePayloadSweep(std::FILE* File)
+{
+    uint32_t NumRows = WriteSweepRows<ElementType>(File, "push_back", SweepMaxBlocks, [](auto& Container, const uint64_t NumBlocks)
+    {
+        return TestPushBack(Container, NumBlocks);
+    });
+
+    NumRows += WriteSweepRows<ElementType>(File, "insert", SweepMaxPositionalBlocks, [](auto& Container, const uint64_t NumBlocks)
+    {
+        const InsertTestResults Results = TestInsert(Container, NumBlocks);
+        return Results.Insert.GetTotalMilliseconds() + Results.IteratorMovement.GetTotalMilliseconds();
+    });
+
+    NumRows += WriteSweepRows<ElementType>(File, "erase", SweepMaxPositionalBlocks, [](auto& Container, const uint64_t NumBlocks)
+    {
+        return TestErase(Container, NumBlocks).GetTotalMilliseconds();
+    });
+
+    return NumRows;
+}
+
+// Every test for every payload type and size, one CSV row per size with the fastest container in the last column
+template <typename... ElementTypes>
+void RunPayloadSweep()
+{
+    std::FILE* File = std::fopen(SweepCsvPath, "w");
+    if (File == nullptr)
+    {
+        std::printf("can't open %s\n", SweepCsvPath);
+        return;
+    }
+
+    std::fprintf(File, "test,payload_bytes,trivially_copyable,count,vector_ms,list_ms,deque_ms,tiered_vector_ms,"
+                       "vector_allocations,vector_peak_bytes,list_allocations,list_peak_bytes,"
+                       "deque_allocations,deque_peak_bytes,tiered_vector_allocations,tiered_vector_peak_bytes,winner\n");
+    const uint32_t NumRows = (WritePayloadSweep<ElementTypes>(File) + ...);
+    std::fclose(File);
+
+    std::printf("payload sweep: %u rows written to %s\n", NumRows, SweepCsvPath);
+}
+
 int32_t main(int argc, char **argv)
 {
     {
         std::printf("block push_back (%lu items)\n", NumBlocksBig);
         std::vector<DataBlock> Vector;
-        std::printf("vector: %fms\n", TestPushBack(Vector, NumBlocksBig));
+        const double VectorTime = TestPushBack(Vector, NumBlocksBig);
+        PrintResult("vector", VectorTime, AllocationCounter::GetStats());
         std::list<DataBlock> List;
-        std::printf("list: %fms\n", TestPushBack(List, NumBlocksBig));
+        const double ListTime = TestPushBack(List, NumBlocksBig);
+        PrintResult("list", ListTime, AllocationCounter::GetStats());
         std::deque<DataBlock> Deque;
-        std::printf("deque: %fms\n", TestPushBack(Deque, NumBlocksBig));
+        const double DequeTime = TestPushBack(Deque, NumBlocksBig);
+        PrintResult("deque", DequeTime, AllocationCounter::GetStats());
+        TieredVector<DataBlock> Tiered;
+        const double TieredTime = TestPushBack(Tiered, NumBlocksBig);
+        PrintResult("tiered vector", TieredTime, AllocationCounter::GetStats());
+
+        double BestListTime = ListTime;
+        for (const ResourceVariant& Variant : MakeResourceVariants())
+        {
+            std::pmr::list<DataBlock> PmrList(Variant.Resource.get());
+            const double PmrListTime = TestPushBack(PmrList, NumBlocksBig);
+            BestListTime = std::min(BestListTime, PmrListTime);
+            PrintResult(GetVariantName("list", Variant.Name).c_str(), PmrListTime, AllocationCounter::GetStats());
+        }
+        for (const ResourceVariant& Variant : MakeResourceVariants())
+        {
+            std::pmr::deque<DataBlock> PmrDeque(Variant.Resource.get());
+            const double PmrDequeTime = TestPushBack(PmrDeque, NumBlocksBig);
+            PrintResult(GetVariantName("deque", Variant.Name).c_str(), PmrDequeTime, AllocationCounter::GetStats());
+        }
+
+        PrintGapBreakdown("push_back", VectorTime, ListTime, BestListTime);
         std::printf("\n");
     }
 
     {
         std::printf("interleaved push_back (%lu items)\n", NumBlocksBig);
-        std::vector<DataBlock> Vector;
-        std::list<DataBlock> List;
-        std::deque<DataBlock> Deque;
+        // global counters can't tell apart containers filled in the same loop, here every container counts its own requests
+        AllocationStats VectorAllocations;
+        AllocationStats ListAllocations;
+        AllocationStats DequeAllocations;
+        std::vector<DataBlock, CountingAllocator<DataBlock>> Vector{CountingAllocator<DataBlock>(VectorAllocations)};
+        std::list<DataBlock, CountingAllocator<DataBlock>> List{CountingAllocator<DataBlock>(ListAllocations)};
+        std::deque<DataBlock, CountingAllocator<DataBlock>> Deque{CountingAllocator<DataBlock>(DequeAllocations)};
         InterleavedTestResults Results = TestInterleavedPushBack(Vector, List, Deque, NumBlocksBig);
 
-        std::printf("vector: %fms\n", Results.VectorTime);
-        std::printf("list: %fms\n", Results.ListTime);
-        std::printf("deque: %fms\n", Results.DequeTime);
+        PrintResult("vector", Results.VectorTime, VectorAllocations);
+        PrintResult("list", Results.ListTime, ListAllocations);
+        PrintResult("deque", Results.DequeTime, DequeAllocations);
+
+        // separate resources for list and deque, a shared one would hand list nodes blocks sized by deque requests
+        double BestListTime = Results.ListTime.GetTotalMilliseconds();
+        std::vector<ResourceVariant> ListVariants = MakeResourceVariants();
+        std::vector<ResourceVariant> DequeVariants = MakeResourceVariants();
+        for (size_t VariantIndex = 0; VariantIndex < ListVariants.size(); ++VariantIndex)
+        {
+            const ResourceVariant& Variant = ListVariants[VariantIndex];
+            AllocationStats PmrListAllocations;
+            AllocationStats PmrDequeAllocations;
+            CountingResource ListResource(PmrListAllocations, Variant.Resource.get());
+            CountingResource DequeResource(PmrDequeAllocations, DequeVariants[VariantIndex].Resource.get());
+
+            std::vector<DataBlock> PmrVector;
+            std::pmr::list<DataBlock> PmrList(&ListResource);
+            std::pmr::deque<DataBlock> PmrDeque(&DequeResource);
+            InterleavedTestResults PmrResults = TestInterleavedPushBack(PmrVector, PmrList, PmrDeque, NumBlocksBig);
+
+            BestListTime = std::min(BestListTime, PmrResults.ListTime.GetTotalMilliseconds());
+            PrintResult(GetVariantName("list", Variant.Name).c_str(), PmrResults.ListTime, PmrListAllocations);
+            PrintResult(GetVariantName("deque", Variant.Name).c_str(), PmrResults.DequeTime, PmrDequeAllocations);
+        }
+
+        PrintGapBreakdown("interleaved push_back", Results.VectorTime.GetTotalMilliseconds(), Results.ListTime.GetTotalMilliseconds(), BestListTime);
         std::printf("\n");
     }
 
@@ -186,17 +432,59 @@ int32_t main(int argc, char **argv)
         InsertTestResults ListResult = TestInsert(List, NumBlocksSmall);
         std::deque<DataBlock> Deque;
         InsertTestResults DequeResult = TestInsert(Deque, NumBlocksSmall);
+        TieredVector<DataBlock> Tiered;
+        InsertTestResults TieredResult = TestInsert(Tiered, NumBlocksSmall);
+
+        struct PmrInsertResults
+        {
+            const char* Name;
+            InsertTestResults List;
+            InsertTestResults Deque;
+        };
+
+        std::vector<PmrInsertResults> PmrResults;
+        std::vector<ResourceVariant> ListVariants = MakeResourceVariants();
+        std::vector<ResourceVariant> DequeVariants = MakeResourceVariants();
+        for (size_t VariantIndex = 0; VariantIndex < ListVariants.size(); ++VariantIndex)
+        {
+            std::pmr::list<DataBlock> PmrList(ListVariants[VariantIndex].Resource.get());
+            std::pmr::deque<DataBlock> PmrDeque(DequeVariants[VariantIndex].Resource.get());
+
+            PmrInsertResults& Results = PmrResults.emplace_back();
+            Results.Name = ListVariants[VariantIndex].Name;
+            Results.List = TestInsert(PmrList, NumBlocksSmall);
+            Results.Deque = TestInsert(PmrDeque, NumBlocksSmall);
+        }
 
         std::printf("insert (%lu items)\n", NumBlocksSmall);
-        std::printf("vector: %fms\n", VectorResult.Insert);
-        std::printf("list: %fms\n", ListResult.Insert);
-        std::printf("deque: %fms\n", DequeResult.Insert);
+        PrintResult("vector", VectorResult.Insert, VectorResult.Allocations);
+        PrintResult("list", ListResult.Insert, ListResult.Allocations);
+        PrintResult("deque", DequeResult.Insert, DequeResult.Allocations);
+        PrintResult("tiered vector", TieredResult.Insert, TieredResult.Allocations);
+        double BestListInsert = ListResult.Insert.GetTotalMilliseconds();
+        for (const PmrInsertResults& Results : PmrResults)
+        {
+            BestListInsert = std::min(BestListInsert, Results.List.Insert.GetTotalMilliseconds());
+            PrintResult(GetVariantName("list", Results.Name).c_str(), Results.List.Insert, Results.List.Allocations);
+            PrintResult(GetVariantName("deque", Results.Name).c_str(), Results.Deque.Insert, Results.Deque.Allocations);
+        }
         std::printf("\n");
 
         std::printf("iterator movement (%lu items)\n", NumBlocksSmall);
-        std::printf("vector: %fms\n", VectorResult.IteratorMovement);
-        std::printf("list: %fms\n", ListResult.IteratorMovement);
-        std::printf("deque: %fms\n", DequeResult.IteratorMovement);
+        VectorResult.IteratorMovement.Print("vector");
+        ListResult.IteratorMovement.Print("list");
+        DequeResult.IteratorMovement.Print("deque");
+        TieredResult.IteratorMovement.Print("tiered vector");
+        double BestListMovement = ListResult.IteratorMovement.GetTotalMilliseconds();
+        for (const PmrInsertResults& Results : PmrResults)
+        {
+            BestListMovement = std::min(BestListMovement, Results.List.IteratorMovement.GetTotalMilliseconds());
+            Results.List.IteratorMovement.Print(GetVariantName("list", Results.Name).c_str());
+            Results.Deque.IteratorMovement.Print(GetVariantName("deque", Results.Name).c_str());
+        }
+
+        PrintGapBreakdown("insert", VectorResult.Insert.GetTotalMilliseconds() + VectorResult.IteratorMovement.GetTotalMilliseconds(),
+                          ListResult.Insert.GetTotalMilliseconds() + ListResult.IteratorMovement.GetTotalMilliseconds(), BestListInsert + BestListMovement);
         std::printf("\n");
     }
 
@@ -206,9 +494,53 @@ int32_t main(int argc, char **argv)
         std::deque<DataBlock> Deque;
 
         std::printf("erase (%lu items)\n", NumBlocksSmall);
-        std::printf("vector: %fms\n", TestErase(Vector, NumBlocksSmall));
-        std::printf("list: %fms\n", TestErase(List, NumBlocksSmall));
-        std::printf("deque: %fms\n", TestErase(Deque, NumBlocksSmall));
+        const LatencyHistogram VectorTime = TestErase(Vector, NumBlocksSmall);
+        PrintResult("vector", VectorTime, AllocationCounter::GetStats());
+        const LatencyHistogram ListTime = TestErase(List, NumBlocksSmall);
+        PrintResult("list", ListTime, AllocationCounter::GetStats());
+        const LatencyHistogram DequeTime = TestErase(Deque, NumBlocksSmall);
+        PrintResult("deque", DequeTime, AllocationCounter::GetStats());
+        TieredVector<DataBlock> Tiered;
+        const LatencyHistogram TieredTime = TestErase(Tiered, NumBlocksSmall);
+        PrintResult("tiered vector", TieredTime, AllocationCounter::GetStats());
+
+        double BestListTime = ListTime.GetTotalMilliseconds();
+        for (const ResourceVariant& Variant : MakeResourceVariants())
+        {
+            std::pmr::list<DataBlock> PmrList(Variant.Resource.get());
+            const LatencyHistogram PmrListTime = TestErase(PmrList, NumBlocksSmall);
+            BestListTime = std::min(BestListTime, PmrListTime.GetTotalMilliseconds());
+            PrintResult(GetVariantName("list", Variant.Name).c_str(), PmrListTime, AllocationCounter::GetStats());
+        }
+        for (const ResourceVariant& Variant : MakeResourceVariants())
+        {
+            std::pmr::deque<DataBlock> PmrDeque(Variant.Resource.get());
+            const LatencyHistogram PmrDequeTime = TestErase(PmrDeque, NumBlocksSmall);
+            PrintResult(GetVariantName("deque", Variant.Name).c_str(), PmrDequeTime, AllocationCounter::GetStats());
+        }
+
+        PrintGapBreakdown("erase", VectorTime.GetTotalMilliseconds(), ListTime.GetTotalMilliseconds(), BestListTime);
         std::printf("\n");
     }
-}
\ No newline at end of file
+
+    {
+        // standard containers would need minutes at this size, every positional operation there is O(n)
+        TieredVector<DataBlock> InsertTiered;
+        InsertTestResults InsertResult = TestInsert(InsertTiered, NumBlocksBig);
+        TieredVector<DataBlock> EraseTiered;
+        const LatencyHistogram EraseTime = TestErase(EraseTiered, NumBlocksBig);
+        const AllocationStats EraseAllocations = AllocationCounter::GetStats();
+
+        std::printf("tiered vector positional operations (%lu items)\n", NumBlocksBig);
+        PrintResult("insert", InsertResult.Insert, InsertResult.Allocations);
+        InsertResult.IteratorMovement.Print("iterator movement");
+        PrintResult("erase", EraseTime, EraseAllocations);
+        std::printf("\n");
+    }
+
+    RunPayloadSweep<Payload<4, true>, Payload<4, false>, Payload<16, true>, Payload<16, false>,
+                    Payload<64, true>, Payload<64, false>, Payload<256, true>, Payload<256, false>>();
+
+    std::printf("\n");
+    RunAssociativeTests();
+}
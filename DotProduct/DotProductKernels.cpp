@@ -0,0 +1,236 @@
+#include "DotProductKernels.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC emits any intrinsic without /arch, the function doesn't need to be marked
+#define TARGET_ISA(Isa)
+#else
+#define TARGET_ISA(Isa) __attribute__((target(Isa)))
+#endif
+
+float DotProductSSE(const std::vector<SSEVector>& Left, const std::vector<SSEVector>& Right)
+{
+    assert(Left.size() == Right.size());
+
+    float Sum = 0.f;
+
+    for (uint32_t VectorId = 0; VectorId < Left.size(); ++VectorId)
+    {
+        Sum += _mm_cvtss_f32(_mm_dp_ps(Left[VectorId].SSEData, Right[VectorId].SSEData, 0xF1));
+    }
+
+    return Sum;
+}
+
+float DotProductSSEUnrolled(const std::vector<SSEVector>& Left, const std::vector<SSEVector>& Right)
+{
+    assert(Left.size() == Right.size());
+
+    float Sum = 0.f;
+
+    const uint32_t NumVectors = Left.size();
+    const uint32_t NumIterations = std::floor(NumVectors / 4);
+
+    for (uint32_t PackId = 0; PackId < NumIterations; ++PackId)
+    {
+        const uint32_t Offset = PackId * 4;
+        Sum += _mm_cvtss_f32(_mm_dp_ps(Left[Offset].SSEData, Right[Offset].SSEData, 0xF1));
+        Sum += _mm_cvtss_f32(_mm_dp_ps(Left[Offset + 1].SSEData, Right[Offset + 1].SSEData, 0xF1));
+        Sum += _mm_cvtss_f32(_mm_dp_ps(Left[Offset + 2].SSEData, Right[Offset + 2].SSEData, 0xF1));
+        Sum += _mm_cvtss_f32(_mm_dp_ps(Left[Offset + 3].SSEData, Right[Offset + 3].SSEData, 0xF1));
+    }
+
+    const uint32_t NumProcessedVectors = NumIterations * 4;
+    for (uint32_t VectorId = NumProcessedVectors; VectorId < NumVectors; ++VectorId)
+    {
+        Sum += _mm_cvtss_f32(_mm_dp_ps(Left[VectorId].SSEData, Right[VectorId].SSEData, 0xF1));
+    }
+
+    return Sum;
+}
+
+TARGET_ISA("avx2,fma")
+float DotProductAVX2(const std::vector<SSEVector>& Left, const std::vector<SSEVector>& Right)
+{
+    assert(Left.size() == Right.size());
+
+    const float* LeftData = Left.data()->Data;
+    const float* RightData = Right.data()->Data;
+    const uint64_t NumFloats = Left.size() * 4;
+
+    __m256 Sum0 = _mm256_setzero_ps();
+    __m256 Sum1 = _mm256_setzero_ps();
+    __m256 Sum2 = _mm256_setzero_ps();
+    __m256 Sum3 = _mm256_setzero_ps();
+
+    uint64_t Index = 0;
+    for (; Index + 32 <= NumFloats; Index += 32)
+    {
+        Sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(LeftData + Index), _mm256_loadu_ps(RightData + Index), Sum0);
+        Sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(LeftData + Index + 8), _mm256_loadu_ps(RightData + Index + 8), Sum1);
+        Sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(LeftData + Index + 16), _mm256_loadu_ps(RightData + Index + 16), Sum2);
+        Sum3 = _mm256_fmadd_ps(_mm256_loadu_ps(LeftData + Index + 24), _mm256_loadu_ps(RightData + Index + 24), Sum3);
+    }
+    for (; Index + 8 <= NumFloats; Index += 8)
+    {
+        Sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(LeftData + Index), _mm256_loadu_ps(RightData + Index), Sum0);
+    }
+
+    const __m256 Sum = _mm256_add_ps(_mm256_add_ps(Sum0, Sum1), _mm256_add_ps(Sum2, Sum3));
+    __m128 Sum128 = _mm_add_ps(_mm256_castps256_ps128(Sum), _mm256_extractf128_ps(Sum, 1));
+
+    // at most one SSEVector is left
+    if (Index < NumFloats)
+    {
+        Sum128 = _mm_fmadd_ps(_mm_loadu_ps(LeftData + Index), _mm_loadu_ps(RightData + Index), Sum128);
+    }
+
+    Sum128 = _mm_add_ps(Sum128, _mm_movehl_ps(Sum128, Sum128));
+    Sum128 = _mm_add_ss(Sum128, _mm_movehdup_ps(Sum128));
+    return _mm_cvtss_f32(Sum128);
+}
+
+TARGET_ISA("avx512f")
+float DotProductAVX512(const std::vector<SSEVector>& Left, const std::vector<SSEVector>& Right)
+{
+    assert(Left.size() == Right.size());
+
+    const float* LeftData = Left.data()->Data;
+    const float* RightData = Right.data()->Data;
+    const uint64_t NumFloats = Left.size() * 4;
+
+    __m512 Sum0 = _mm512_setzero_ps();
+    __m512 Sum1 = _mm512_setzero_ps();
+    __m512 Sum2 = _mm512_setzero_ps();
+    __m512 Sum3 = _mm512_setzero_ps();
+
+    uint64_t Index = 0;
+    for (; Index + 64 <= NumFloats; Index += 64)
+    {
+        Sum0 = _mm512_fmadd_ps(_mm512_loadu_ps(LeftData + Index), _mm512_loadu_ps(RightData + Index), Sum0);
+        Sum1 = _mm512_fmadd_ps(_mm512_loadu_ps(LeftData + Index + 16), _mm512_loadu_ps(RightData + Index + 16), Sum1);
+        Sum2 = _mm512_fmadd_ps(_mm512_loadu_ps(LeftData + Index + 32), _mm512_loadu_ps(RightData + Index + 32), Sum2);
+        Sum3 = _mm512_fmadd_ps(_mm512_loadu_ps(LeftData + Index + 48), _mm512_loadu_ps(RightData + Index + 48), Sum3);
+    }
+    for (; Index + 16 <= NumFloats; Index += 16)
+    {
+        Sum0 = _mm512_fmadd_ps(_mm512_loadu_ps(LeftData + Index), _mm512_loadu_ps(RightData + Index), Sum0);
+    }
+
+    // masked loads read nothing past the end
+    if (Index < NumFloats)
+    {
+        const __mmask16 Mask = static_cast<__mmask16>((1u << (NumFloats - Index)) - 1);
+        Sum1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(Mask, LeftData + Index), _mm512_maskz_loadu_ps(Mask, RightData + Index), Sum1);
+    }
+
+    // halves are added in place, _mm512_reduce_add_ps and the unmasked shuffles read undefined vectors GCC warns about,
+    // the full masked forms pass Sum instead and compile to the same instructions
+    __m512 Sum = _mm512_add_ps(_mm512_add_ps(Sum0, Sum1), _mm512_add_ps(Sum2, Sum3));
+    Sum = _mm512_add_ps(Sum, _mm512_mask_shuffle_f32x4(Sum, 0xFFFF, Sum, Sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    Sum = _mm512_add_ps(Sum, _mm512_mask_shuffle_f32x4(Sum, 0xFFFF, Sum, Sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    Sum = _mm512_add_ps(Sum, _mm512_mask_permute_ps(Sum, 0xFFFF, Sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    Sum = _mm512_add_ps(Sum, _mm512_mask_permute_ps(Sum, 0xFFFF, Sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm512_cvtss_f32(Sum);
+}
+
+const std::vector<DotProductKernel>& GetDotProductKernels()
+{
+    static const std::vector<DotProductKernel> Kernels = {
+        {"DotProduct SSE", InstructionSet::SSE41, &DotProductSSE},
+        {"DotProduct AVX2", InstructionSet::AVX2, &DotProductAVX2},
+        {"DotProduct AVX512", InstructionSet::AVX512, &DotProductAVX512},
+    };
+
+    return Kernels;
+}
+
+InstructionSet GetSupportedInstructionSet()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int Registers[4];
+    __cpuid(Registers, 1);
+    const bool bOsSavesYmm = (Registers[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+    const bool bFma = (Registers[2] & (1 << 12)) != 0;
+    // opmask and upper zmm state too
+    const bool bOsSavesZmm = bOsSavesYmm && (_xgetbv(0) & 0xE6) == 0xE6;
+
+    __cpuidex(Registers, 7, 0);
+    const bool bAvx2 = (Registers[1] & (1 << 5)) != 0;
+    const bool bAvx512 = (Registers[1] & (1 << 16)) != 0;
+
+    if (bAvx512 && bOsSavesZmm)
+    {
+        return InstructionSet::AVX512;
+    }
+    if (bAvx2 && bFma && bOsSavesYmm)
+    {
+        return InstructionSet::AVX2;
+    }
+#else
+    // also checks the OS saves the wider registers
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return InstructionSet::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return InstructionSet::AVX2;
+    }
+#endif
+
+    return InstructionSet::SSE41;
+}
+
+const DotProductKernel& SelectDotProductKernel(const InstructionSet MaxIsa)
+{
+    const InstructionSet Supported = GetSupportedInstructionSet();
+    const std::vector<DotProductKernel>& Kernels = GetDotProductKernels();
+
+    const DotProductKernel* Result = &Kernels.front();
+    for (const DotProductKernel& Kernel : Kernels)
+    {
+        if (Kernel.Isa <= Supported && Kernel.Isa <= MaxIsa)
+        {
+            Result = &Kernel;
+        }
+    }
+
+    return *Result;
+}
+
+bool ParseInstructionSet(const char* Name, InstructionSet& OutIsa)
+{
+    for (const InstructionSet Isa : {InstructionSet::SSE41, InstructionSet::AVX2, InstructionSet::AVX512})
+    {
+        if (std::strcmp(Name, ToString(Isa)) == 0)
+        {
+            OutIsa = Isa;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* ToString(const InstructionSet Isa)
+{
+    switch (Isa)
+    {
+    case InstructionSet::SSE41:
+        return "sse4.1";
+    case InstructionSet::AVX2:
+        return "avx2";
+    case InstructionSet::AVX512:
+        return "avx512";
+    }
+
+    return "unknown";
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <smmintrin.h>
+
+union SSEVector
+{
+    struct
+    {
+        float X;
+        float Y;
+        float Z;
+        float W;
+    };
+
+    float Data[4];
+    __m128 SSEData;
+};
+
+// Ordered, a higher set includes the lower ones
+enum class InstructionSet : uint8_t
+{
+    SSE41,
+    AVX2,
+    AVX512
+};
+
+using DotProductFunction = float (*)(const std::vector<SSEVector>& Left, const std::vector<SSEVector>& Right);
+
+struct DotProductKernel
+{
+    const char* Name;
+    InstructionSet Isa;
+    DotProductFunction Function;
+};
+
+float DotProductSSE(const std::vector<SSEVector>& Left, const std::vector<SSEVector>& Right);
+float DotProductSSEUnrolled(const std::vector<SSEVector>& Left, const std::vector<SSEVector>& Right);
+
+// Vectors are read as one array of floats and multiplied with FMA into four accumulators, summed horizontally once at the end.
+// Built with target attributes, so the rest of the program stays SSE4.1 and runs on any CPU, call only when supported.
+float DotProductAVX2(const std::vector<SSEVector>& Left, const std::vector<SSEVector>& Right);
+float DotProductAVX512(const std::vector<SSEVector>& Left, const std::vector<SSEVector>& Right);
+
+// Kernel of every instruction set, lowest first
+const std::vector<DotProductKernel>& GetDotProductKernels();
+
+// Highest instruction set supported by both the CPU and the OS
+InstructionSet GetSupportedInstructionSet();
+
+// Best kernel supported by the CPU, not above MaxIsa. SSE4.1 is the fallback, the program is built for it anyway.
+const DotProductKernel& SelectDotProductKernel(InstructionSet MaxIsa = InstructionSet::AVX512);
+
+// "sse4.1", "avx2" or "avx512", false for anything else
+bool ParseInstructionSet(const char* Name, InstructionSet& OutIsa);
+
+const char* ToString(InstructionSet Isa);
@@ -3,10 +3,10 @@
 #include <functional>
 #include <iostream>
 
-#include <immintrin.h>
-#include <smmintrin.h>
+#include <cstring>
 #include <random>
 
+#include "DotProductKernels.h"
 #include "PerformanceCounter.h"
 
 
@@ -18,20 +18,6 @@ constexpr uint32_t NumTests = 1000;
 constexpr uint64_t NumComponents = 1048576;
 #endif
 
-union SSEVector
-{
-    struct
-    {
-        float X;
-        float Y;
-        float Z;
-        float W;
-    };
-
-    float Data[4];
-    __m128 SSEData;
-};
-
 void GenerateRandomVector(std::vector<SSEVector>& Vector)
 {
     std::default_random_engine RandomGenerator(std::chrono::high_resolution_clock::now().time_since_epoch().count());
@@ -115,49 +101,27 @@ float DotProductUnrolled(const std::vector<SSEVector>& Left, const std::vector<S
     return Sum;
 }
 
-float DotProductSSE(const std::vector<SSEVector>& Left, const std::vector<SSEVector>& Right)
+// Every component is one multiply and one add
+void PrintPerf(const char* Name, DotProductFunction Function)
 {
-    assert(Left.size() == Right.size());
-
-    float Sum = 0.f;
-
-    for (uint32_t VectorId = 0; VectorId < Left.size(); ++VectorId)
-    {
-        Sum += _mm_cvtss_f32(_mm_dp_ps(Left[VectorId].SSEData, Right[VectorId].SSEData, 0xF1));
-    }
-
-    return Sum;
+    const double Time = RunTest(Function);
+    std::printf("%s: %fms, %.2f GFLOP/s\n", Name, Time, 2. * NumComponents / (Time * 1e6));
 }
 
-float DotProductSSEUnrolled(const std::vector<SSEVector>& Left, const std::vector<SSEVector>& Right)
+// --isa sse4.1|avx2|avx512 caps the dispatched kernel, to test the lower ones on a newer CPU
+int32_t main(int32_t Argc, char** Argv)
 {
-    assert(Left.size() == Right.size());
-
-    float Sum = 0.f;
-
-    const uint32_t NumVectors = Left.size();
-    const uint32_t NumIterations = std::floor(NumVectors / 4);
-
-    for (uint32_t PackId = 0; PackId < NumIterations; ++PackId)
+    InstructionSet MaxIsa = InstructionSet::AVX512;
+    if (Argc > 2 && std::strcmp(Argv[1], "--isa") == 0 && !ParseInstructionSet(Argv[2], MaxIsa))
     {
-        const uint32_t Offset = PackId * 4;
-        Sum += _mm_cvtss_f32(_mm_dp_ps(Left[Offset].SSEData, Right[Offset].SSEData, 0xF1));
-        Sum += _mm_cvtss_f32(_mm_dp_ps(Left[Offset + 1].SSEData, Right[Offset + 1].SSEData, 0xF1));
-        Sum += _mm_cvtss_f32(_mm_dp_ps(Left[Offset + 2].SSEData, Right[Offset + 2].SSEData, 0xF1));
-        Sum += _mm_cvtss_f32(_mm_dp_ps(Left[Offset + 3].SSEData, Right[Offset + 3].SSEData, 0xF1));
+        std::printf("Unknown instruction set %s, expected sse4.1, avx2 or avx512\n", Argv[2]);
+        return 1;
     }
 
-    const uint32_t NumProcessedVectors = NumIterations * 4;
-    for (uint32_t VectorId = NumProcessedVectors; VectorId < NumVectors; ++VectorId)
-    {
-        Sum += _mm_cvtss_f32(_mm_dp_ps(Left[VectorId].SSEData, Right[VectorId].SSEData, 0xF1));
-    }
+    const InstructionSet SupportedIsa = GetSupportedInstructionSet();
+    const DotProductKernel& Dispatched = SelectDotProductKernel(MaxIsa);
+    std::printf("Supported: %s, dispatched: %s\n", ToString(SupportedIsa), Dispatched.Name);
 
-    return Sum;
-}
-
-int32_t main()
-{
     std::vector<SSEVector> VecA, VecB;
     GenerateRandomVector(VecA);
     GenerateRandomVector(VecB);
@@ -167,10 +131,31 @@ int32_t main()
     std::printf("DotProduct Unrolled: %f\n", DotProductUnrolled(VecA, VecB));
     std::printf("DotProduct SSE: %f\n", DotProductSSE(VecA, VecB));
     std::printf("DotProduct SSE Unrolled: %f\n", DotProductSSEUnrolled(VecA, VecB));
+    for (const DotProductKernel& Kernel : GetDotProductKernels())
+    {
+        if (Kernel.Isa != InstructionSet::SSE41 && Kernel.Isa <= SupportedIsa)
+        {
+            std::printf("%s: %f\n", Kernel.Name, Kernel.Function(VecA, VecB));
+        }
+    }
 
     std::printf("=======| Perf Tests |=======\n");
-    std::printf("DotProduct: %fms\n", RunTest(&DotProduct));
-    std::printf("DotProduct Unrolled: %fms\n", RunTest(&DotProductUnrolled));
-    std::printf("DotProduct SSE: %fms\n", RunTest(&DotProductSSE));
-    std::printf("DotProduct SSE Unrolled: %fms\n", RunTest(&DotProductSSEUnrolled));
+    PrintPerf("DotProduct", &DotProduct);
+    PrintPerf("DotProduct Unrolled", &DotProductUnrolled);
+    PrintPerf("DotProduct SSE", &DotProductSSE);
+    PrintPerf("DotProduct SSE Unrolled", &DotProductSSEUnrolled);
+    for (const DotProductKernel& Kernel : GetDotProductKernels())
+    {
+        if (Kernel.Isa == InstructionSet::SSE41)
+        {
+            continue;
+        }
+        if (Kernel.Isa > SupportedIsa)
+        {
+            std::printf("%s: not supported\n", Kernel.Name);
+            continue;
+        }
+        PrintPerf(Kernel.Name, Kernel.Function);
+    }
+    PrintPerf("DotProduct Dispatched", Dispatched.Function);
 }
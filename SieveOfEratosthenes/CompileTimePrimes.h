@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+// Sieves evaluated by the compiler. Bounds are small, so a plain sieve over bools is good enough.
+
+template <uint32_t Bound>
+consteval std::array<bool, Bound> MakeCompileTimeComposites()
+{
+    std::array<bool, Bound> Composites{};
+    for (uint32_t Number = 0; Number < Bound && Number < 2; ++Number)
+    {
+        Composites[Number] = true;
+    }
+
+    for (uint64_t Number = 2; Number * Number < Bound; ++Number)
+    {
+        if (!Composites[Number])
+        {
+            for (uint64_t Multiple = Number * Number; Multiple < Bound; Multiple += Number)
+            {
+                Composites[Multiple] = true;
+            }
+        }
+    }
+
+    return Composites;
+}
+
+template <uint32_t Bound>
+consteval uint32_t CountCompileTimeOddPrimes()
+{
+    const std::array<bool, Bound> Composites = MakeCompileTimeComposites<Bound>();
+
+    uint32_t Result = 0;
+    for (uint32_t Number = 3; Number < Bound; Number += 2)
+    {
+        Result += !Composites[Number];
+    }
+
+    return Result;
+}
+
+// Odd primes below Bound in ascending order
+template <uint32_t Bound>
+consteval std::array<uint32_t, CountCompileTimeOddPrimes<Bound>()> MakeCompileTimeOddPrimes()
+{
+    const std::array<bool, Bound> Composites = MakeCompileTimeComposites<Bound>();
+
+    std::array<uint32_t, CountCompileTimeOddPrimes<Bound>()> Result{};
+    uint32_t PrimeIndex = 0;
+    for (uint32_t Number = 3; Number < Bound; Number += 2)
+    {
+        if (!Composites[Number])
+        {
+            Result[PrimeIndex++] = Number;
+        }
+    }
+
+    return Result;
+}
+
+// Odd primes below sqrt(2^32), enough to sieve any range of 32-bit numbers without discovering base primes first
+constexpr uint32_t CompileTimeBasePrimesBound = 65536;
+inline constexpr auto CompileTimeBasePrimes = MakeCompileTimeOddPrimes<CompileTimeBasePrimesBound>();
+static_assert(CompileTimeBasePrimes.size() == 6541);
+
+// Complete odd table for a constant bound, so prime queries below Bound become table lookups.
+template <uint32_t Bound>
+struct SmallPrimeTable
+{
+    static constexpr uint32_t NumWords = (Bound / 2 + 63) / 64;
+
+    // Same layout as runtime odd tables: bit i stands for 2 * i + 1, set bit means "not a prime"
+    static constexpr std::array<uint64_t, NumWords> Composites = []() consteval
+    {
+        const std::array<bool, Bound> NumberComposites = MakeCompileTimeComposites<Bound>();
+
+        std::array<uint64_t, NumWords> Result{};
+        for (uint32_t BitIndex = 0; BitIndex < NumWords * 64; ++BitIndex)
+        {
+            const uint32_t Number = 2 * BitIndex + 1;
+            // padding past the bound is never a prime
+            if (Number >= Bound || NumberComposites[Number])
+            {
+                Result[BitIndex / 64] |= 1llu << (BitIndex % 64);
+            }
+        }
+
+        return Result;
+    }();
+
+    // Number of odd primes stored before every word
+    static constexpr std::array<uint32_t, NumWords + 1> PrimesBefore = []() consteval
+    {
+        std::array<uint32_t, NumWords + 1> Result{};
+        for (uint32_t WordIndex = 0; WordIndex < NumWords; ++WordIndex)
+        {
+            Result[WordIndex + 1] = Result[WordIndex] + std::popcount(~Composites[WordIndex]);
+        }
+
+        return Result;
+    }();
+
+    static constexpr bool IsPrime(const uint32_t Number)
+    {
+        if (Number % 2 == 0)
+        {
+            return Number == 2;
+        }
+
+        const uint32_t BitIndex = Number / 2;
+        return !(Composites[BitIndex / 64] >> (BitIndex % 64) & 1);
+    }
+
+    // Number of primes below Number, Number can't exceed Bound
+    static constexpr uint32_t CountPrimes(const uint32_t Number)
+    {
+        if (Number <= 2)
+        {
+            return 0;
+        }
+
+        const uint32_t EndIndex = Number / 2;
+        const uint32_t WordIndex = EndIndex / 64;
+        const uint64_t PartialWord = EndIndex % 64 != 0 ? ~Composites[WordIndex] & ((1llu << (EndIndex % 64)) - 1) : 0;
+
+        // two isn't stored in the table
+        return 1 + PrimesBefore[WordIndex] + std::popcount(PartialWord);
+    }
+};
@@ -0,0 +1,200 @@
+#include "PrimeCounting.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "SegmentedSieve.h"
+
+namespace
+{
+    // Prefix sums over entries [1, Size], entry 0 is unused
+    template <typename T>
+    class FenwickTree
+    {
+    public:
+        explicit FenwickTree(std::vector<T>&& Values)
+            : Tree(std::move(Values))
+        {
+            // linear build, every node pushes its partial sum to the parent
+            for (uint64_t Index = 1; Index < Tree.size(); ++Index)
+            {
+                const uint64_t Parent = Index + (Index & (0 - Index));
+                if (Parent < Tree.size())
+                {
+                    Tree[Parent] += Tree[Index];
+                }
+            }
+        }
+
+        void Subtract(uint64_t Index, const T Value)
+        {
+            for (; Index < Tree.size(); Index += Index & (0 - Index))
+            {
+                Tree[Index] -= Value;
+            }
+        }
+
+        T PrefixSum(uint64_t Index) const
+        {
+            T Result = 0;
+            for (; Index > 0; Index &= Index - 1)
+            {
+                Result += Tree[Index];
+            }
+
+            return Result;
+        }
+
+    private:
+        std::vector<T> Tree;
+    };
+
+    struct CountPolicy
+    {
+        using LargeType = uint64_t;
+        // small limit is far below 2^32
+        using SmallType = uint32_t;
+
+        static uint64_t Weight(uint64_t)
+        {
+            return 1;
+        }
+
+        // numbers in [2, Value] left after crossing off multiples of two: two and odd numbers from three
+        static LargeType Initial(const uint64_t Value)
+        {
+            return Value < 2 ? 0 : (Value - 1) / 2 + 1;
+        }
+    };
+
+    struct SumPolicy
+    {
+        using LargeType = PrimeSum;
+        using SmallType = uint64_t;
+
+        static uint64_t Weight(const uint64_t Number)
+        {
+            return Number;
+        }
+
+        static LargeType Initial(const uint64_t Value)
+        {
+            if (Value < 2)
+            {
+                return 0;
+            }
+
+            // odd numbers up to Value sum to NumOdd^2, one isn't counted and two is
+            const LargeType NumOdd = (Value + 1) / 2;
+            return NumOdd * NumOdd + 1;
+        }
+    };
+
+    uint64_t ChooseSmallLimit(const uint64_t N, const uint64_t Sqrt)
+    {
+        const double Cbrt = std::cbrt(static_cast<double>(N));
+        const uint64_t SmallLimit = std::min(static_cast<uint64_t>(Cbrt * Cbrt), MaxSmallLimit);
+
+        return std::min(std::max(SmallLimit, Sqrt), N);
+    }
+
+    // S(v) is the weight of numbers in [2, v] which are primes or have no prime factor below the current prime.
+    // Processing prime p removes numbers whose smallest factor is p: S(v) -= w(p) * (S(v / p) - S(p - 1)).
+    // Once every prime up to sqrt(N) is processed, S(N) is the weight of primes up to N.
+    template <typename TPolicy>
+    typename TPolicy::LargeType LucyHedgehog(const uint64_t N)
+    {
+        using LargeType = typename TPolicy::LargeType;
+        using SmallType = typename TPolicy::SmallType;
+
+        if (N < 2)
+        {
+            return 0;
+        }
+
+        const uint64_t Sqrt = ISqrt(N);
+        const uint64_t SmallLimit = ChooseSmallLimit(N, Sqrt);
+
+        // Large[i] holds S(N / i) for every N / i above SmallLimit
+        const uint64_t NumLarge = N / (SmallLimit + 1);
+        std::vector<LargeType> Large(NumLarge + 1);
+        for (uint64_t Index = 1; Index <= NumLarge; ++Index)
+        {
+            Large[Index] = TPolicy::Initial(N / Index);
+        }
+
+        // Small values use odd table indexing, entry i stands for 2 * i + 1 and two is added on query
+        const uint64_t NumSmall = (SmallLimit - 1) / 2;
+        std::vector<SmallType> SmallWeights(NumSmall + 1);
+        for (uint64_t Index = 1; Index <= NumSmall; ++Index)
+        {
+            SmallWeights[Index] = static_cast<SmallType>(TPolicy::Weight(2 * Index + 1));
+        }
+
+        FenwickTree<SmallType> Small(std::move(SmallWeights));
+        std::vector<uint64_t> CrossedOff(NumSmall / 64 + 1);
+
+        const auto GetSmall = [&Small](const uint64_t Value) -> LargeType
+        {
+            return Value < 2 ? 0 : LargeType(Small.PrefixSum((Value - 1) / 2)) + TPolicy::Weight(2);
+        };
+
+        // S(p - 1), weight of primes below the current one
+        LargeType BelowPrime = TPolicy::Weight(2);
+
+        for (const uint64_t Prime : FindBasePrimes(static_cast<uint32_t>(Sqrt)))
+        {
+            const uint64_t PrimeSquare = Prime * Prime;
+            const LargeType PrimeWeight = TPolicy::Weight(Prime);
+
+            // Large[i * p] is still from the previous step, because i grows
+            const uint64_t LastLarge = std::min(NumLarge, N / PrimeSquare);
+            for (uint64_t Index = 1; Index <= LastLarge; ++Index)
+            {
+                const uint64_t Divisor = Index * Prime;
+                const LargeType Quotient = Divisor <= NumLarge ? Large[Divisor] : GetSmall(N / Divisor);
+                Large[Index] -= PrimeWeight * (Quotient - BelowPrime);
+            }
+
+            for (uint64_t Multiple = PrimeSquare; Multiple <= SmallLimit; Multiple += 2 * Prime)
+            {
+                const uint64_t Index = Multiple / 2;
+                const uint64_t Mask = 1llu << (Index % 64);
+                if ((CrossedOff[Index / 64] & Mask) == 0)
+                {
+                    CrossedOff[Index / 64] |= Mask;
+                    Small.Subtract(Index, static_cast<SmallType>(TPolicy::Weight(Multiple)));
+                }
+            }
+
+            BelowPrime += PrimeWeight;
+        }
+
+        return NumLarge > 0 ? Large[1] : GetSmall(N);
+    }
+}
+
+uint64_t CountPrimes(const uint64_t N)
+{
+    return N > 0 ? LucyHedgehog<CountPolicy>(N - 1) : 0;
+}
+
+PrimeSum SumPrimes(const uint64_t N)
+{
+    return N > 0 ? LucyHedgehog<SumPolicy>(N - 1) : 0;
+}
+
+std::string ToString(PrimeSum Value)
+{
+    std::string Result;
+    do
+    {
+        Result.push_back(static_cast<char>('0' + Value % 10));
+        Value /= 10;
+    }
+    while (Value != 0);
+
+    std::reverse(Result.begin(), Result.end());
+    return Result;
+}
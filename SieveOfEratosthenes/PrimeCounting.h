@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Prime counting without a table of primes, Lucy_Hedgehog's method.
+// Counts are kept for every value N / i. Values above SmallLimit live in a plain array, values below it in a Fenwick tree
+// over odd numbers, so crossing off a small number costs O(log N) instead of updating every value above it.
+// With SmallLimit close to N^(2/3) this takes about O(N^(2/3)) time, only primes up to sqrt(N) are ever sieved.
+
+#if defined(__SIZEOF_INT128__)
+// sum of primes below 10^13 takes about 82 bits
+using PrimeSum = unsigned __int128;
+#else
+// no 128-bit integer, sums wrap around past 2^64
+using PrimeSum = uint64_t;
+#endif
+
+// Upper limit for values kept in the Fenwick tree, bounds memory to a few hundred MiB
+constexpr uint64_t MaxSmallLimit = 1llu << 27;
+
+// Number of primes below N
+uint64_t CountPrimes(uint64_t N);
+
+// Sum of primes below N
+PrimeSum SumPrimes(uint64_t N);
+
+std::string ToString(PrimeSum Value);
@@ -0,0 +1,110 @@
+#include "PrimeGenerator.h"
+
+#include <algorithm>
+#include <bit>
+
+PrimeGenerator::PrimeGenerator(const uint64_t InLow, const uint64_t InHigh, const uint64_t SegmentBytes)
+    : bYieldTwo(InLow <= 2 && InHigh > 2)
+    , EndIndex(InHigh / 2)
+    , SegmentStart(InLow / 2)
+    , SegmentBits(std::max<uint64_t>(SegmentBytes / sizeof(uint64_t), 1) * 64)
+    , NumBits(0)
+    , WordIndex(0)
+    , Primes(0)
+    , PendingBasePrime(0)
+{
+    Segment.resize(SegmentBits / 64);
+
+    // odd primes p with p^2 < InHigh
+    const uint64_t BaseHigh = InHigh > 0 ? ISqrt(InHigh - 1) + 1 : 0;
+    if (BaseHigh > 3 && SegmentStart < EndIndex)
+    {
+        BasePrimes = std::make_unique<PrimeGenerator>(3, BaseHigh, SegmentBytes);
+    }
+}
+
+bool PrimeGenerator::Next(uint64_t& OutPrime)
+{
+    if (bYieldTwo)
+    {
+        bYieldTwo = false;
+        OutPrime = 2;
+        return true;
+    }
+
+    while (Primes == 0)
+    {
+        if (WordIndex + 1 < (NumBits + 63) / 64)
+        {
+            Primes = Segment[++WordIndex];
+        }
+        else if (!SieveNextSegment())
+        {
+            return false;
+        }
+    }
+
+    const uint64_t BitIndex = SegmentStart + WordIndex * 64 + std::countr_zero(Primes);
+    Primes &= Primes - 1;
+
+    OutPrime = 2 * BitIndex + 1;
+    return true;
+}
+
+bool PrimeGenerator::SieveNextSegment()
+{
+    SegmentStart += NumBits;
+    if (SegmentStart >= EndIndex)
+    {
+        NumBits = 0;
+        return false;
+    }
+
+    NumBits = std::min(SegmentBits, EndIndex - SegmentStart);
+    const uint64_t LastNumber = 2 * (SegmentStart + NumBits - 1) + 1;
+
+    // sieving primes are added only when their square reaches the segment
+    while (BasePrimes != nullptr)
+    {
+        if (PendingBasePrime == 0 && !BasePrimes->Next(PendingBasePrime))
+        {
+            BasePrimes.reset();
+            break;
+        }
+
+        if (PendingBasePrime * PendingBasePrime > LastNumber)
+        {
+            break;
+        }
+
+        SievingPrimes.push_back(MakeSievingPrime(static_cast<uint32_t>(PendingBasePrime), SegmentStart));
+        PendingBasePrime = 0;
+    }
+
+    const uint64_t NumWords = (NumBits + 63) / 64;
+    std::fill_n(Segment.begin(), NumWords, 0);
+
+    if (SegmentStart == 0)
+    {
+        // one is neither prime nor composite number
+        Segment[0] |= 1;
+    }
+
+    CrossOffSegment(Segment.data(), NumBits, SievingPrimes);
+
+    // keep primes instead of composites, so scanning can skip straight to set bits
+    for (uint64_t Word = 0; Word < NumWords; ++Word)
+    {
+        Segment[Word] = ~Segment[Word];
+    }
+
+    if (NumBits % 64 != 0)
+    {
+        Segment[NumWords - 1] &= (1llu << NumBits % 64) - 1;
+    }
+
+    WordIndex = 0;
+    Primes = Segment[0];
+
+    return true;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "SegmentedSieve.h"
+
+// Yields primes from [Low, High) in ascending order. The range is sieved lazily one segment at a time,
+// so memory doesn't depend on High - Low: one segment buffer plus sieving primes up to sqrt(High).
+// Sieving primes are themselves taken lazily from a nested generator.
+//
+// for (const uint64_t Prime : PrimeGenerator(Low, High)) { ... }
+class PrimeGenerator
+{
+public:
+    static constexpr uint64_t DefaultSegmentBytes = 128 * 1024;
+
+    class Iterator
+    {
+    public:
+        using value_type = uint64_t;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator()
+            : Generator(nullptr)
+            , Prime(0)
+        {
+        }
+
+        explicit Iterator(PrimeGenerator* InGenerator)
+            : Generator(InGenerator)
+            , Prime(0)
+        {
+            ++*this;
+        }
+
+        uint64_t operator*() const
+        {
+            return Prime;
+        }
+
+        Iterator& operator++()
+        {
+            if (!Generator->Next(Prime))
+            {
+                Generator = nullptr;
+            }
+
+            return *this;
+        }
+
+        void operator++(int)
+        {
+            ++*this;
+        }
+
+        bool operator==(std::default_sentinel_t) const
+        {
+            return Generator == nullptr;
+        }
+
+    private:
+        PrimeGenerator* Generator;
+        uint64_t Prime;
+    };
+
+    PrimeGenerator(uint64_t InLow, uint64_t InHigh, uint64_t SegmentBytes = DefaultSegmentBytes);
+
+    PrimeGenerator(PrimeGenerator&&) = default;
+    PrimeGenerator& operator=(PrimeGenerator&&) = default;
+
+    // Writes next prime to OutPrime, returns false when the range is exhausted.
+    bool Next(uint64_t& OutPrime);
+
+    Iterator begin()
+    {
+        return Iterator(this);
+    }
+
+    std::default_sentinel_t end() const
+    {
+        return {};
+    }
+
+private:
+    bool SieveNextSegment();
+
+    // Two isn't stored in the odd table
+    bool bYieldTwo;
+    // Odd table indices of the range, EndIndex is exclusive
+    uint64_t EndIndex;
+    uint64_t SegmentStart;
+    uint64_t SegmentBits;
+    uint64_t NumBits;
+
+    std::vector<uint64_t> Segment;
+    // Index of the word in Segment that is being scanned and its remaining prime bits
+    uint64_t WordIndex;
+    uint64_t Primes;
+
+    std::unique_ptr<PrimeGenerator> BasePrimes;
+    // Base prime already taken from BasePrimes, but not needed yet, 0 when there is none
+    uint64_t PendingBasePrime;
+    std::vector<SievingPrime> SievingPrimes;
+};
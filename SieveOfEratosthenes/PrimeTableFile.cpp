@@ -0,0 +1,363 @@
+#include "PrimeTableFile.h"
+
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "PrimeGenerator.h"
+#include "SieveReduction.h"
+
+namespace
+{
+    void AppendVarint(std::vector<uint8_t>& Payload, uint64_t Value)
+    {
+        while (Value >= 0x80)
+        {
+            Payload.push_back(static_cast<uint8_t>(Value) | 0x80);
+            Value >>= 7;
+        }
+
+        Payload.push_back(static_cast<uint8_t>(Value));
+    }
+
+    uint64_t FindLastPrime(std::span<const uint64_t> Table, const uint64_t Bound)
+    {
+        const uint64_t NumIndices = Bound / 2;
+        for (uint64_t WordIndex = (NumIndices + 63) / 64; WordIndex-- > 0;)
+        {
+            uint64_t Primes = ~Table[WordIndex];
+            const uint64_t WordBits = NumIndices - WordIndex * 64;
+            if (WordBits < 64)
+            {
+                Primes &= (1llu << WordBits) - 1;
+            }
+
+            if (Primes != 0)
+            {
+                return 2 * (WordIndex * 64 + 63 - std::countl_zero(Primes)) + 1;
+            }
+        }
+
+        return Bound > 2 ? 2 : 0;
+    }
+
+    void EncodeDeltas(std::vector<uint8_t>& Payload, std::span<const uint64_t> Table, const uint64_t Bound)
+    {
+        const uint64_t NumIndices = Bound / 2;
+        uint64_t PreviousPrime = 1;
+
+        for (uint64_t WordIndex = 0; WordIndex < (NumIndices + 63) / 64; ++WordIndex)
+        {
+            uint64_t Primes = ~Table[WordIndex];
+            const uint64_t WordBits = NumIndices - WordIndex * 64;
+            if (WordBits < 64)
+            {
+                Primes &= (1llu << WordBits) - 1;
+            }
+
+            while (Primes != 0)
+            {
+                const uint64_t Prime = 2 * (WordIndex * 64 + std::countr_zero(Primes)) + 1;
+                AppendVarint(Payload, (Prime - PreviousPrime) / 2);
+                PreviousPrime = Prime;
+                Primes &= Primes - 1;
+            }
+        }
+    }
+
+    bool WriteTableFile(const char* Path, const PrimeTableHeader& Header, const void* Payload)
+    {
+        const std::string TemporaryPath = std::string(Path) + ".tmp";
+
+        {
+            std::ofstream File(TemporaryPath, std::ios::binary | std::ios::trunc);
+            File.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+            File.write(static_cast<const char*>(Payload), static_cast<std::streamsize>(Header.PayloadBytes));
+            if (!File)
+            {
+                return false;
+            }
+        }
+
+        std::error_code Error;
+        std::filesystem::rename(TemporaryPath, Path, Error);
+        return !Error;
+    }
+
+    PrimeTableHeader MakeHeader(const EPrimeTableEncoding Encoding, const uint64_t Bound)
+    {
+        PrimeTableHeader Header{};
+        std::memcpy(Header.Magic, PrimeTableHeader::ExpectedMagic, sizeof(Header.Magic));
+        Header.Version = PrimeTableHeader::CurrentVersion;
+        Header.Encoding = Encoding;
+        Header.Bound = Bound;
+
+        return Header;
+    }
+}
+
+MappedPrimeTable::~MappedPrimeTable()
+{
+    Close();
+}
+
+bool MappedPrimeTable::Open(const char* Path)
+{
+    Close();
+
+    if (!MapFile(Path))
+    {
+        Close();
+        return false;
+    }
+
+    const bool bValid = std::memcmp(Header->Magic, PrimeTableHeader::ExpectedMagic, sizeof(Header->Magic)) == 0
+        && Header->Version == PrimeTableHeader::CurrentVersion
+        && (Header->Encoding == EPrimeTableEncoding::OddBits || Header->Encoding == EPrimeTableEncoding::DeltaVarint)
+        && Header->PayloadBytes <= MappingSize - sizeof(PrimeTableHeader)
+        && (Header->Encoding != EPrimeTableEncoding::OddBits || Header->PayloadBytes >= (Header->Bound / 2 + 63) / 64 * sizeof(uint64_t));
+
+    if (!bValid)
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+
+bool MappedPrimeTable::MapFile(const char* Path)
+{
+    FileHandle = CreateFileA(Path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (FileHandle == INVALID_HANDLE_VALUE)
+    {
+        FileHandle = nullptr;
+        return false;
+    }
+
+    LARGE_INTEGER FileSize;
+    if (!GetFileSizeEx(FileHandle, &FileSize) || static_cast<uint64_t>(FileSize.QuadPart) < sizeof(PrimeTableHeader))
+    {
+        return false;
+    }
+
+    MappingHandle = CreateFileMappingA(FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (MappingHandle == nullptr)
+    {
+        return false;
+    }
+
+    MappingSize = FileSize.QuadPart;
+    Header = static_cast<const PrimeTableHeader*>(MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0));
+
+    return Header != nullptr;
+}
+
+#else
+
+bool MappedPrimeTable::MapFile(const char* Path)
+{
+    const int FileDescriptor = open(Path, O_RDONLY);
+    if (FileDescriptor < 0)
+    {
+        return false;
+    }
+
+    struct stat FileStat{};
+    if (fstat(FileDescriptor, &FileStat) != 0 || static_cast<uint64_t>(FileStat.st_size) < sizeof(PrimeTableHeader))
+    {
+        close(FileDescriptor);
+        return false;
+    }
+
+    // mapping stays valid after the descriptor is closed
+    void* Mapping = mmap(nullptr, FileStat.st_size, PROT_READ, MAP_SHARED, FileDescriptor, 0);
+    close(FileDescriptor);
+    if (Mapping == MAP_FAILED)
+    {
+        return false;
+    }
+
+    MappingSize = FileStat.st_size;
+    Header = static_cast<const PrimeTableHeader*>(Mapping);
+
+    return true;
+}
+
+#endif
+
+void MappedPrimeTable::Close()
+{
+#if defined(_WIN32) || defined(_WIN64)
+    if (Header != nullptr)
+    {
+        UnmapViewOfFile(Header);
+    }
+    if (MappingHandle != nullptr)
+    {
+        CloseHandle(MappingHandle);
+    }
+    if (FileHandle != nullptr)
+    {
+        CloseHandle(FileHandle);
+    }
+
+    MappingHandle = nullptr;
+    FileHandle = nullptr;
+#else
+    if (Header != nullptr)
+    {
+        munmap(const_cast<PrimeTableHeader*>(Header), MappingSize);
+    }
+#endif
+
+    Header = nullptr;
+    MappingSize = 0;
+}
+
+std::span<const uint64_t> MappedPrimeTable::GetWords() const
+{
+    return {reinterpret_cast<const uint64_t*>(Header + 1), Header->PayloadBytes / sizeof(uint64_t)};
+}
+
+std::span<const uint8_t> MappedPrimeTable::GetDeltas() const
+{
+    return {reinterpret_cast<const uint8_t*>(Header + 1), Header->PayloadBytes};
+}
+
+DeltaPrimeReader::DeltaPrimeReader(std::span<const uint8_t> Deltas, const uint64_t Bound)
+    : Cursor(Deltas.data())
+    , End(Deltas.data() + Deltas.size())
+    , Prime(1)
+    , bYieldTwo(Bound > 2)
+{
+}
+
+bool DeltaPrimeReader::Next(uint64_t& OutPrime)
+{
+    if (bYieldTwo)
+    {
+        bYieldTwo = false;
+        OutPrime = 2;
+        return true;
+    }
+
+    uint64_t Delta = 0;
+    for (uint32_t Shift = 0; Cursor != End; Shift += 7)
+    {
+        const uint8_t Byte = *Cursor++;
+        Delta |= static_cast<uint64_t>(Byte & 0x7F) << Shift;
+        if ((Byte & 0x80) == 0)
+        {
+            Prime += 2 * Delta;
+            OutPrime = Prime;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool WritePrimeTable(const char* Path, std::span<const uint64_t> Table, const uint64_t Bound, const EPrimeTableEncoding Encoding)
+{
+    const PrimesSummary Summary = SummarizeOddTable(Table, 0, Bound);
+
+    PrimeTableHeader Header = MakeHeader(Encoding, Bound);
+    Header.PrimesCount = Summary.Count;
+    Header.PrimesSum = Summary.Sum;
+    Header.LastPrime = FindLastPrime(Table, Bound);
+
+    if (Encoding == EPrimeTableEncoding::OddBits)
+    {
+        Header.PayloadBytes = (Bound / 2 + 63) / 64 * sizeof(uint64_t);
+        return WriteTableFile(Path, Header, Table.data());
+    }
+
+    std::vector<uint8_t> Payload;
+    EncodeDeltas(Payload, Table, Bound);
+
+    Header.PayloadBytes = Payload.size();
+    return WriteTableFile(Path, Header, Payload.data());
+}
+
+bool LoadOrBuildPrimeTable(MappedPrimeTable& Table, const char* Path, const uint64_t Bound, const EPrimeTableEncoding Encoding, const uint64_t SegmentBytes)
+{
+    const bool bExisting = Table.Open(Path) && Table.GetHeader().Encoding == Encoding;
+    if (bExisting && Table.GetHeader().Bound >= Bound)
+    {
+        return true;
+    }
+
+    const uint64_t SievedNumbers = bExisting ? Table.GetHeader().Bound : 0;
+    bool bWritten = false;
+
+    if (Encoding == EPrimeTableEncoding::OddBits)
+    {
+        std::vector<uint64_t> Words;
+        if (bExisting)
+        {
+            const std::span<const uint64_t> ExistingWords = Table.GetWords();
+            Words.assign(ExistingWords.begin(), ExistingWords.end());
+        }
+
+        ExtendCompositesSegmented(Words, SievedNumbers, Bound, SegmentBytes);
+        bWritten = WritePrimeTable(Path, Words, Bound, Encoding);
+    }
+    else if (bExisting)
+    {
+        // delta encoded primes are extended by appending the new ones
+        const PrimeTableHeader& ExistingHeader = Table.GetHeader();
+        const std::span<const uint8_t> ExistingDeltas = Table.GetDeltas();
+
+        PrimeTableHeader Header = ExistingHeader;
+        std::vector<uint8_t> Payload(ExistingDeltas.begin(), ExistingDeltas.end());
+
+        // odd primes are chained from one, two isn't part of the deltas
+        uint64_t PreviousPrime = ExistingHeader.LastPrime > 2 ? ExistingHeader.LastPrime : 1;
+        for (const uint64_t Prime : PrimeGenerator(SievedNumbers, Bound, SegmentBytes))
+        {
+            if (Prime == 2)
+            {
+                continue;
+            }
+
+            AppendVarint(Payload, (Prime - PreviousPrime) / 2);
+            PreviousPrime = Prime;
+
+            ++Header.PrimesCount;
+            Header.PrimesSum += Prime;
+        }
+
+        if (SievedNumbers <= 2 && Bound > 2)
+        {
+            ++Header.PrimesCount;
+            Header.PrimesSum += 2;
+        }
+
+        Header.Bound = Bound;
+        Header.LastPrime = PreviousPrime > 1 ? PreviousPrime : (Bound > 2 ? 2 : 0);
+        Header.PayloadBytes = Payload.size();
+        bWritten = WriteTableFile(Path, Header, Payload.data());
+    }
+    else
+    {
+        std::vector<uint64_t> Words;
+        FindCompositesSegmented(Words, Bound, SegmentBytes);
+        bWritten = WritePrimeTable(Path, Words, Bound, Encoding);
+    }
+
+    return bWritten && Table.Open(Path);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "SegmentedSieve.h"
+
+// Finished sieve saved on disk, so repeated runs only have to map the file.
+// Layout: PrimeTableHeader followed by PayloadBytes of payload, starting at 8 byte aligned offset.
+
+enum class EPrimeTableEncoding : uint32_t
+{
+    // odd table words, exactly as produced by FindCompositesSegmented
+    OddBits = 0,
+    // LEB128 varints of (Prime - PreviousPrime) / 2 for odd primes, starting from PreviousPrime = 1
+    DeltaVarint = 1,
+};
+
+struct PrimeTableHeader
+{
+    static constexpr char ExpectedMagic[8] = {'P', 'R', 'I', 'M', 'E', 'T', 'B', 'L'};
+    static constexpr uint32_t CurrentVersion = 1;
+
+    char Magic[8];
+    uint32_t Version;
+    EPrimeTableEncoding Encoding;
+    // Table holds numbers below Bound
+    uint64_t Bound;
+    uint64_t PrimesCount;
+    uint64_t PrimesSum;
+    // Largest prime below Bound, so delta encoded tables can be extended
+    uint64_t LastPrime;
+    uint64_t PayloadBytes;
+};
+
+static_assert(sizeof(PrimeTableHeader) % sizeof(uint64_t) == 0);
+
+// Read only memory mapping of a prime table file. Payload is never copied.
+class MappedPrimeTable
+{
+public:
+    MappedPrimeTable() = default;
+    ~MappedPrimeTable();
+
+    MappedPrimeTable(const MappedPrimeTable&) = delete;
+    MappedPrimeTable& operator=(const MappedPrimeTable&) = delete;
+
+    // Returns false when file doesn't exist or isn't a valid prime table.
+    bool Open(const char* Path);
+    void Close();
+
+    [[nodiscard]] bool IsOpen() const
+    {
+        return Header != nullptr;
+    }
+
+    [[nodiscard]] const PrimeTableHeader& GetHeader() const
+    {
+        return *Header;
+    }
+
+    // Valid only for EPrimeTableEncoding::OddBits
+    [[nodiscard]] std::span<const uint64_t> GetWords() const;
+
+    // Valid only for EPrimeTableEncoding::DeltaVarint
+    [[nodiscard]] std::span<const uint8_t> GetDeltas() const;
+
+private:
+    bool MapFile(const char* Path);
+
+    const PrimeTableHeader* Header = nullptr;
+    uint64_t MappingSize = 0;
+
+#if defined(_WIN32) || defined(_WIN64)
+    void* FileHandle = nullptr;
+    void* MappingHandle = nullptr;
+#endif
+};
+
+// Decodes delta varint payload one prime at a time, including 2.
+class DeltaPrimeReader
+{
+public:
+    DeltaPrimeReader(std::span<const uint8_t> Deltas, uint64_t Bound);
+
+    bool Next(uint64_t& OutPrime);
+
+private:
+    const uint8_t* Cursor;
+    const uint8_t* End;
+    uint64_t Prime;
+    bool bYieldTwo;
+};
+
+// Writes table to a temporary file and renames it to Path, so mappings of the previous file stay valid.
+bool WritePrimeTable(const char* Path, std::span<const uint64_t> Table, uint64_t Bound, EPrimeTableEncoding Encoding);
+
+// Maps table from Path when it covers Bound. Smaller tables are extended by sieving only the missing range,
+// missing or invalid files are rebuilt from scratch. In both cases the new table is written to Path before mapping.
+bool LoadOrBuildPrimeTable(MappedPrimeTable& Table, const char* Path, uint64_t Bound, EPrimeTableEncoding Encoding, uint64_t SegmentBytes);
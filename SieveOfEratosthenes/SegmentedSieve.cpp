@@ -0,0 +1,305 @@
+#include "SegmentedSieve.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#include "CompileTimePrimes.h"
+#include "SieveReduction.h"
+
+uint64_t ISqrt(const uint64_t Value)
+{
+    uint64_t Result = static_cast<uint64_t>(std::sqrt(static_cast<double>(Value)));
+
+    // double has only 53 bits of mantissa, so fix up the estimate
+    while (Result > 0 && (Result > UINT32_MAX || Result * Result > Value))
+    {
+        --Result;
+    }
+    while (Result < UINT32_MAX && (Result + 1) * (Result + 1) <= Value)
+    {
+        ++Result;
+    }
+
+    return Result;
+}
+
+std::vector<uint32_t> FindBasePrimes(const uint32_t Limit)
+{
+    if (Limit >= CompileTimeBasePrimesBound)
+    {
+        return SieveBasePrimes(Limit);
+    }
+
+    return {CompileTimeBasePrimes.begin(), std::upper_bound(CompileTimeBasePrimes.begin(), CompileTimeBasePrimes.end(), Limit)};
+}
+
+std::vector<uint32_t> SieveBasePrimes(const uint32_t Limit)
+{
+    std::vector<uint32_t> Result;
+    if (Limit < 3)
+    {
+        return Result;
+    }
+
+    std::vector<bool> Composites((Limit - 1) / 2 + 1);
+    for (uint64_t BitIndex = 1; BitIndex < Composites.size(); ++BitIndex)
+    {
+        if (Composites[BitIndex])
+        {
+            continue;
+        }
+
+        const uint64_t Prime = 2 * BitIndex + 1;
+        Result.push_back(static_cast<uint32_t>(Prime));
+
+        for (uint64_t Multiple = Prime * Prime; Multiple <= Limit; Multiple += 2 * Prime)
+        {
+            Composites[(Multiple - 1) / 2] = true;
+        }
+    }
+
+    return Result;
+}
+
+SievingPrime MakeSievingPrime(const uint32_t Prime, const uint64_t FirstIndex)
+{
+    // work on distances from the first number, so multiples past 2^64 can't overflow
+    const uint64_t FirstNumber = 2 * FirstIndex + 1;
+    const uint64_t Square = static_cast<uint64_t>(Prime) * Prime;
+
+    if (Square >= FirstNumber)
+    {
+        return {Prime, (Square - FirstNumber) / 2};
+    }
+
+    uint64_t Distance = (Prime - FirstNumber % Prime) % Prime;
+    // only odd multiples are stored in the table
+    if (Distance % 2 != 0)
+    {
+        Distance += Prime;
+    }
+
+    return {Prime, Distance / 2};
+}
+
+namespace
+{
+    // Multiples of pre-sieved primes repeat every 3 * 5 * 7 * 11 * 13 odd numbers. Pattern is that long in words,
+    // so it can be tiled with plain word copies from any word aligned segment start.
+    class PreSievePattern
+    {
+    public:
+        static constexpr uint64_t NumWords = 3 * 5 * 7 * 11 * 13;
+
+        PreSievePattern()
+            : Words(NumWords)
+        {
+            for (const uint32_t Prime : PreSievedPrimes)
+            {
+                // odd multiples of Prime sit every Prime bits, starting from Prime itself
+                for (uint64_t BitIndex = Prime / 2; BitIndex < NumWords * 64; BitIndex += Prime)
+                {
+                    Words[BitIndex / 64] |= 1llu << (BitIndex % 64);
+                }
+            }
+        }
+
+        void Apply(uint64_t* Segment, const uint64_t NumSegmentWords, const uint64_t FirstWord) const
+        {
+            uint64_t PatternWord = FirstWord % NumWords;
+            for (uint64_t CopiedWords = 0; CopiedWords < NumSegmentWords;)
+            {
+                const uint64_t NumCopyWords = std::min(NumSegmentWords - CopiedWords, NumWords - PatternWord);
+                std::memcpy(Segment + CopiedWords, Words.data() + PatternWord, NumCopyWords * sizeof(uint64_t));
+
+                CopiedWords += NumCopyWords;
+                PatternWord = 0;
+            }
+        }
+
+    private:
+        std::vector<uint64_t> Words;
+    };
+}
+
+void PreSieveSegment(uint64_t* Segment, const uint64_t NumBits, const uint64_t FirstIndex)
+{
+    static const PreSievePattern Pattern;
+    Pattern.Apply(Segment, (NumBits + 63) / 64, FirstIndex / 64);
+
+    if (FirstIndex == 0)
+    {
+        // pre-sieved primes are crossed off by the pattern as their own multiples, one is neither prime nor composite
+        for (const uint32_t Prime : PreSievedPrimes)
+        {
+            Segment[0] &= ~(1llu << Prime / 2);
+        }
+
+        Segment[0] |= 1;
+    }
+}
+
+void CrossOffSegment(uint64_t* Segment, const uint64_t NumBits, std::vector<SievingPrime>& SievingPrimes)
+{
+    for (SievingPrime& Sieving : SievingPrimes)
+    {
+        // consecutive odd multiples are 2 * Prime apart, which is Prime bits in the odd table
+        const uint64_t Step = Sieving.Prime;
+        uint64_t Index = Sieving.NextIndex;
+        for (; Index < NumBits; Index += Step)
+        {
+            Segment[Index / 64] |= 1llu << (Index % 64);
+        }
+
+        Sieving.NextIndex = Index - NumBits;
+    }
+}
+
+void FindCompositesSegmented(std::vector<uint64_t>& Result, const uint64_t NumbersToCheck, const uint64_t SegmentBytes, std::span<const uint32_t> BasePrimes,
+                             const bool bPreSieve)
+{
+    Result.clear();
+    ExtendCompositesSegmented(Result, 0, NumbersToCheck, SegmentBytes, BasePrimes, bPreSieve);
+}
+
+void ExtendCompositesSegmented(std::vector<uint64_t>& Table, const uint64_t SievedNumbers, const uint64_t NumbersToCheck, const uint64_t SegmentBytes,
+                               std::span<const uint32_t> BasePrimes, const bool bPreSieve)
+{
+    const uint64_t NumIndices = NumbersToCheck / 2;
+    // segments have to start at word boundary
+    const uint64_t SegmentBits = std::max<uint64_t>(SegmentBytes / sizeof(uint64_t), 1) * 64;
+
+    // restart from the word holding the first number that wasn't sieved yet
+    const uint64_t FirstWord = std::min<uint64_t>(SievedNumbers / 2 / 64, Table.size());
+    const uint64_t FirstIndex = FirstWord * 64;
+
+    Table.resize((NumIndices + 63) / 64);
+    std::fill(Table.begin() + std::min<uint64_t>(FirstWord, Table.size()), Table.end(), 0);
+    if (FirstIndex >= NumIndices)
+    {
+        return;
+    }
+
+    if (FirstIndex == 0)
+    {
+        // one is neither prime nor composite number
+        Table[0] |= 1;
+    }
+
+    std::vector<uint32_t> FoundBasePrimes;
+    if (BasePrimes.empty())
+    {
+        FoundBasePrimes = FindBasePrimes(ISqrt(NumbersToCheck - 1));
+        BasePrimes = FoundBasePrimes;
+    }
+
+    std::vector<SievingPrime> SievingPrimes;
+    for (const uint32_t Prime : BasePrimes)
+    {
+        if (!bPreSieve || Prime > LargestPreSievedPrime)
+        {
+            SievingPrimes.push_back(MakeSievingPrime(Prime, FirstIndex));
+        }
+    }
+
+    for (uint64_t SegmentStart = FirstIndex; SegmentStart < NumIndices; SegmentStart += SegmentBits)
+    {
+        const uint64_t NumBits = std::min(SegmentBits, NumIndices - SegmentStart);
+        if (bPreSieve)
+        {
+            PreSieveSegment(&Table[SegmentStart / 64], NumBits, SegmentStart);
+        }
+
+        CrossOffSegment(&Table[SegmentStart / 64], NumBits, SievingPrimes);
+    }
+}
+
+PrimesSummary SieveParallel(std::vector<uint64_t>* Result, const uint64_t NumbersToCheck, const uint32_t NumThreads, const uint64_t SegmentBytes)
+{
+    const uint64_t NumIndices = NumbersToCheck / 2;
+    const uint64_t NumWords = (NumIndices + 63) / 64;
+    const uint64_t SegmentWords = std::max<uint64_t>(SegmentBytes / sizeof(uint64_t), 1);
+
+    if (Result != nullptr)
+    {
+        Result->assign(NumWords, 0);
+    }
+
+    const std::vector<uint32_t> BasePrimes = FindBasePrimes(ISqrt(NumbersToCheck > 0 ? NumbersToCheck - 1 : 0));
+
+    // Threads get whole words, so no two threads ever write the same machine word
+    const uint64_t WordsPerThread = (NumWords + NumThreads - 1) / NumThreads;
+    std::vector<PrimesSummary> ThreadSummaries(NumThreads);
+
+    auto SieveRange = [&](const uint32_t ThreadId)
+    {
+        const uint64_t FirstWord = std::min(NumWords, ThreadId * WordsPerThread);
+        const uint64_t LastWord = std::min(NumWords, FirstWord + WordsPerThread);
+        if (FirstWord == LastWord)
+        {
+            return;
+        }
+
+        std::vector<SievingPrime> SievingPrimes;
+        SievingPrimes.reserve(BasePrimes.size());
+        for (const uint32_t Prime : BasePrimes)
+        {
+            if (Prime > LargestPreSievedPrime)
+            {
+                SievingPrimes.push_back(MakeSievingPrime(Prime, FirstWord * 64));
+            }
+        }
+
+        std::vector<uint64_t> Buffer;
+        if (Result == nullptr)
+        {
+            Buffer.resize(SegmentWords);
+        }
+
+        PrimesSummary& Summary = ThreadSummaries[ThreadId];
+        for (uint64_t SegmentWord = FirstWord; SegmentWord < LastWord; SegmentWord += SegmentWords)
+        {
+            const uint64_t SegmentStart = SegmentWord * 64;
+            const uint64_t NumBits = std::min(std::min(LastWord, SegmentWord + SegmentWords) * 64, NumIndices) - SegmentStart;
+
+            uint64_t* Segment = Result != nullptr ? &(*Result)[SegmentWord] : Buffer.data();
+            PreSieveSegment(Segment, NumBits, SegmentStart);
+
+            CrossOffSegment(Segment, NumBits, SievingPrimes);
+
+            const PrimesSummary SegmentSummary = SummarizeSegmentSSE(Segment, NumBits, SegmentStart);
+            Summary.Count += SegmentSummary.Count;
+            Summary.Sum += SegmentSummary.Sum;
+        }
+    };
+
+    std::vector<std::thread> Threads;
+    for (uint32_t ThreadId = 1; ThreadId < NumThreads; ++ThreadId)
+    {
+        Threads.emplace_back(SieveRange, ThreadId);
+    }
+    SieveRange(0);
+
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+
+    // we are skipping even numbers so two has to be added separately
+    PrimesSummary Total;
+    if (NumbersToCheck > 2)
+    {
+        Total.Count = 1;
+        Total.Sum = 2;
+    }
+
+    for (const PrimesSummary& Summary : ThreadSummaries)
+    {
+        Total.Count += Summary.Count;
+        Total.Sum += Summary.Sum;
+    }
+
+    return Total;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <vector>
+
+// Odd table layout: bit i stands for the number 2 * i + 1, set bit means "not a prime".
+// Tables are stored in raw 64-bit words so segments can be aligned to word boundaries.
+
+struct PrimesSummary
+{
+    uint64_t Count = 0;
+    uint64_t Sum = 0;
+};
+
+struct SievingPrime
+{
+    uint32_t Prime;
+    // Index of the next odd multiple to cross off, relative to the start of the current segment.
+    uint64_t NextIndex;
+};
+
+uint64_t ISqrt(uint64_t Value);
+
+// Returns odd primes <= Limit, taken from the compile time table when Limit fits in it.
+std::vector<uint32_t> FindBasePrimes(uint32_t Limit);
+
+// Returns odd primes <= Limit, always discovered with a simple sieve at runtime.
+std::vector<uint32_t> SieveBasePrimes(uint32_t Limit);
+
+// Creates sieving prime whose first multiple is the smallest odd multiple >= max(Prime^2, 2 * FirstIndex + 1).
+SievingPrime MakeSievingPrime(uint32_t Prime, uint64_t FirstIndex);
+
+// Small primes whose multiples are copied from a repeating pattern instead of being crossed off one by one
+constexpr uint32_t PreSievedPrimes[] = {3, 5, 7, 11, 13};
+constexpr uint32_t LargestPreSievedPrime = PreSievedPrimes[std::size(PreSievedPrimes) - 1];
+
+// Overwrites NumBits bits of Segment with the pattern of multiples of PreSievedPrimes.
+// FirstIndex of the segment has to be word aligned.
+void PreSieveSegment(uint64_t* Segment, uint64_t NumBits, uint64_t FirstIndex);
+
+// Crosses off multiples of every sieving prime in NumBits bits of Segment and moves their next multiples
+// to the following segment.
+void CrossOffSegment(uint64_t* Segment, uint64_t NumBits, std::vector<SievingPrime>& SievingPrimes);
+
+// Sieves odd numbers below NumbersToCheck one SegmentBytes sized window at a time.
+// BasePrimes have to cover sqrt(NumbersToCheck), when empty they are taken from FindBasePrimes.
+// With bPreSieve every segment starts from PreSieveSegment pattern and PreSievedPrimes are skipped when crossing off.
+void FindCompositesSegmented(std::vector<uint64_t>& Result, uint64_t NumbersToCheck, uint64_t SegmentBytes, std::span<const uint32_t> BasePrimes = {},
+                             bool bPreSieve = true);
+
+// Grows Table sieved for numbers below SievedNumbers, so it covers numbers below NumbersToCheck.
+// Only the new part of the table is sieved.
+void ExtendCompositesSegmented(std::vector<uint64_t>& Table, uint64_t SievedNumbers, uint64_t NumbersToCheck, uint64_t SegmentBytes,
+                               std::span<const uint32_t> BasePrimes = {}, bool bPreSieve = true);
+
+// Splits odd table into disjoint word ranges and sieves each of them on its own thread.
+// When Result is null the table isn't stored and every thread reuses its own segment buffer,
+// so ranges far larger than memory can be counted.
+PrimesSummary SieveParallel(std::vector<uint64_t>* Result, uint64_t NumbersToCheck, uint32_t NumThreads, uint64_t SegmentBytes);
@@ -0,0 +1,152 @@
+#include "SieveReduction.h"
+
+#include <algorithm>
+#include <bit>
+
+#include <immintrin.h>
+
+namespace
+{
+    inline void AddPrimesWord(PrimesSummary& Summary, uint64_t Primes, const uint64_t WordFirstIndex)
+    {
+        Summary.Count += std::popcount(Primes);
+
+        while (Primes != 0)
+        {
+            Summary.Sum += 2 * (WordFirstIndex + std::countr_zero(Primes)) + 1;
+            Primes &= Primes - 1;
+        }
+    }
+}
+
+PrimesSummary SummarizeSegment(const uint64_t* Segment, const uint64_t NumBits, const uint64_t FirstIndex)
+{
+    PrimesSummary Result;
+
+    const uint64_t NumWords = (NumBits + 63) / 64;
+    for (uint64_t WordIndex = 0; WordIndex < NumWords; ++WordIndex)
+    {
+        uint64_t Primes = ~Segment[WordIndex];
+        const uint64_t WordBits = NumBits - WordIndex * 64;
+        if (WordBits < 64)
+        {
+            Primes &= (1llu << WordBits) - 1;
+        }
+
+        AddPrimesWord(Result, Primes, FirstIndex + WordIndex * 64);
+    }
+
+    return Result;
+}
+
+PrimesSummary SummarizeSegmentSSE(const uint64_t* Segment, const uint64_t NumBits, const uint64_t FirstIndex)
+{
+    const uint64_t NumPairs = NumBits / 128;
+
+    // Popcount and sum of set bit positions of every nibble
+    const __m128i NibbleCounts = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m128i NibblePositions = _mm_setr_epi8(0, 0, 1, 1, 2, 2, 3, 3, 3, 3, 4, 4, 5, 5, 6, 6);
+    const __m128i ByteIndices = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7);
+    const __m128i LowNibbleMask = _mm_set1_epi8(0x0F);
+    const __m128i LowDWordMask = _mm_set1_epi64x(0xFFFFFFFF);
+    const __m128i Ones16 = _mm_set1_epi16(1);
+    const __m128i AllBits = _mm_set1_epi8(-1);
+    const __m128i Zero = _mm_setzero_si128();
+
+    // Per word lanes: number of primes, sum of their bit positions and number of primes weighted by word index
+    __m128i Counts = Zero;
+    __m128i Positions = Zero;
+    __m128i WeightedCounts = Zero;
+    __m128i WordIndices = _mm_set_epi64x(1, 0);
+    const __m128i WordIndicesStep = _mm_set1_epi64x(2);
+
+    for (uint64_t PairIndex = 0; PairIndex < NumPairs; ++PairIndex)
+    {
+        const __m128i Primes = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Segment) + PairIndex), AllBits);
+
+        const __m128i Low = _mm_and_si128(Primes, LowNibbleMask);
+        const __m128i High = _mm_and_si128(_mm_srli_epi16(Primes, 4), LowNibbleMask);
+
+        const __m128i HighCounts = _mm_shuffle_epi8(NibbleCounts, High);
+        const __m128i ByteCounts = _mm_add_epi8(_mm_shuffle_epi8(NibbleCounts, Low), HighCounts);
+        // bits of the high nibble are 4 positions further
+        const __m128i BytePositions = _mm_add_epi8(_mm_add_epi8(_mm_shuffle_epi8(NibblePositions, Low), _mm_shuffle_epi8(NibblePositions, High)),
+                                                   _mm_slli_epi16(HighCounts, 2));
+
+        const __m128i WordCounts = _mm_sad_epu8(ByteCounts, Zero);
+
+        // sum of byte index * byte count, reduced to the low dword of every word lane
+        __m128i ByteWeights = _mm_madd_epi16(_mm_maddubs_epi16(ByteCounts, ByteIndices), Ones16);
+        ByteWeights = _mm_and_si128(_mm_add_epi32(ByteWeights, _mm_srli_epi64(ByteWeights, 32)), LowDWordMask);
+
+        Counts = _mm_add_epi64(Counts, WordCounts);
+        Positions = _mm_add_epi64(Positions, _mm_add_epi64(_mm_sad_epu8(BytePositions, Zero), _mm_slli_epi64(ByteWeights, 3)));
+        WeightedCounts = _mm_add_epi64(WeightedCounts, _mm_mul_epu32(WordCounts, WordIndices));
+        WordIndices = _mm_add_epi64(WordIndices, WordIndicesStep);
+    }
+
+    const uint64_t Count = _mm_extract_epi64(Counts, 0) + _mm_extract_epi64(Counts, 1);
+    const uint64_t Position = _mm_extract_epi64(Positions, 0) + _mm_extract_epi64(Positions, 1);
+    const uint64_t WeightedCount = _mm_extract_epi64(WeightedCounts, 0) + _mm_extract_epi64(WeightedCounts, 1);
+
+    // prime at bit i of word w is 2 * (FirstIndex + 64 * w + i) + 1
+    PrimesSummary Result;
+    Result.Count = Count;
+    Result.Sum = (2 * FirstIndex + 1) * Count + 128 * WeightedCount + 2 * Position;
+
+    const uint64_t NumProcessedBits = NumPairs * 128;
+    const PrimesSummary Rest = SummarizeSegment(Segment + NumPairs * 2, NumBits - NumProcessedBits, FirstIndex + NumProcessedBits);
+    Result.Count += Rest.Count;
+    Result.Sum += Rest.Sum;
+
+    return Result;
+}
+
+PrimesSummary SummarizeOddTable(std::span<const uint64_t> Table, const uint64_t Low, const uint64_t High)
+{
+    PrimesSummary Result;
+    if (Low >= High)
+    {
+        return Result;
+    }
+
+    // two isn't stored in the table
+    if (Low <= 2 && High > 2)
+    {
+        Result.Count = 1;
+        Result.Sum = 2;
+    }
+
+    const uint64_t FirstIndex = Low / 2;
+    const uint64_t EndIndex = High / 2;
+    if (FirstIndex >= EndIndex)
+    {
+        return Result;
+    }
+
+    // unaligned head of the range, aligned rest goes to the vectorized reduction
+    uint64_t AlignedIndex = FirstIndex;
+    if (FirstIndex % 64 != 0)
+    {
+        const uint64_t WordIndex = FirstIndex / 64;
+        AlignedIndex = std::min((WordIndex + 1) * 64, EndIndex);
+
+        uint64_t Primes = ~Table[WordIndex] >> (FirstIndex % 64);
+        const uint64_t NumHeadBits = AlignedIndex - FirstIndex;
+        if (NumHeadBits < 64)
+        {
+            Primes &= (1llu << NumHeadBits) - 1;
+        }
+
+        AddPrimesWord(Result, Primes, FirstIndex);
+    }
+
+    if (AlignedIndex < EndIndex)
+    {
+        const PrimesSummary Rest = SummarizeSegmentSSE(&Table[AlignedIndex / 64], EndIndex - AlignedIndex, AlignedIndex);
+        Result.Count += Rest.Count;
+        Result.Sum += Rest.Sum;
+    }
+
+    return Result;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include "SegmentedSieve.h"
+
+// Reductions over odd tables, whole 64-bit words at a time.
+
+// Counts primes with popcount and sums them by walking set bits with countr_zero.
+// Segment[0] bit 0 stands for 2 * FirstIndex + 1, bits past NumBits are ignored.
+PrimesSummary SummarizeSegment(const uint64_t* Segment, uint64_t NumBits, uint64_t FirstIndex);
+
+// Same as SummarizeSegment, but two words at a time with SSSE3 nibble lookup popcount.
+// Sum is computed from counts weighted by bit position, so there are no branches on the data.
+PrimesSummary SummarizeSegmentSSE(const uint64_t* Segment, uint64_t NumBits, uint64_t FirstIndex);
+
+// Exact count and sum of primes in [Low, High), Table has to be sieved at least up to High.
+PrimesSummary SummarizeOddTable(std::span<const uint64_t> Table, uint64_t Low, uint64_t High);
@@ -0,0 +1,213 @@
+#include "WheelSieve.h"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace
+{
+    // Cofactor following WheelOffsets[7] is 31, the first one of the next turn of the wheel
+    constexpr uint32_t NextWheelOffset(const uint32_t WheelIndex)
+    {
+        return WheelIndex == 7 ? 31 : WheelOffsets[WheelIndex + 1];
+    }
+
+    constexpr uint32_t FindWheelIndex(const uint32_t Residue)
+    {
+        uint32_t WheelIndex = 0;
+        while (WheelIndex < 7 && WheelOffsets[WheelIndex] < Residue)
+        {
+            ++WheelIndex;
+        }
+
+        return WheelIndex;
+    }
+
+    // Multiples of a prime p = 30 * q + r with cofactors from one turn of the wheel always land on the same bits
+    // and their bytes differ only by multiples of q, so everything except q can be computed at compile time.
+    struct WheelPattern
+    {
+        // Bit of the multiple with cofactor WheelOffsets[J]
+        uint8_t Masks[8];
+        // Byte of the multiple with cofactor WheelOffsets[J] relative to the first multiple of the turn, without q part
+        uint32_t Offsets[8];
+        // Distance in bytes to the next multiple, without q part
+        uint32_t Steps[8];
+    };
+
+    constexpr WheelPattern MakeWheelPattern(const uint32_t Residue)
+    {
+        WheelPattern Pattern{};
+        for (uint32_t WheelIndex = 0; WheelIndex < 8; ++WheelIndex)
+        {
+            Pattern.Masks[WheelIndex] = 1 << FindWheelIndex(Residue * WheelOffsets[WheelIndex] % 30);
+            Pattern.Offsets[WheelIndex] = Residue * WheelOffsets[WheelIndex] / 30;
+            Pattern.Steps[WheelIndex] = Residue * NextWheelOffset(WheelIndex) / 30 - Residue * WheelOffsets[WheelIndex] / 30;
+        }
+
+        return Pattern;
+    }
+
+    template <uint32_t Residue, size_t... WheelIndices>
+    inline void CrossOffTurn(uint8_t* Turn, const uint64_t Quotient, std::index_sequence<WheelIndices...>)
+    {
+        static constexpr WheelPattern Pattern = MakeWheelPattern(Residue);
+        ((Turn[Quotient * (WheelOffsets[WheelIndices] - 1) + Pattern.Offsets[WheelIndices]] |= Pattern.Masks[WheelIndices]), ...);
+    }
+
+    template <uint32_t ResidueIndex>
+    void CrossOffWheelPrime(uint8_t* Sieve, const uint64_t SieveSize, WheelSievingPrime& Sieving)
+    {
+        constexpr uint32_t Residue = WheelOffsets[ResidueIndex];
+        static constexpr WheelPattern Pattern = MakeWheelPattern(Residue);
+
+        const uint64_t Quotient = Sieving.Quotient;
+        uint64_t Byte = Sieving.NextByte;
+        uint32_t WheelIndex = Sieving.WheelIndex;
+
+        auto CrossOffNext = [&]()
+        {
+            Sieve[Byte] |= Pattern.Masks[WheelIndex];
+            Byte += Quotient * (NextWheelOffset(WheelIndex) - WheelOffsets[WheelIndex]) + Pattern.Steps[WheelIndex];
+            WheelIndex = (WheelIndex + 1) % 8;
+        };
+
+        // finish current turn of the wheel one multiple at a time
+        while (WheelIndex != 0 && Byte < SieveSize)
+        {
+            CrossOffNext();
+        }
+
+        if (WheelIndex == 0)
+        {
+            // cross off whole turns without bound checks while the last multiple of a turn fits in the segment
+            const uint64_t Prime = Quotient * 30 + Residue;
+            const uint64_t LastOffset = Quotient * (WheelOffsets[7] - 1) + Pattern.Offsets[7];
+            while (Byte + LastOffset < SieveSize)
+            {
+                CrossOffTurn<Residue>(Sieve + Byte, Quotient, std::make_index_sequence<8>{});
+                Byte += Prime;
+            }
+
+            while (Byte < SieveSize)
+            {
+                CrossOffNext();
+            }
+        }
+
+        Sieving.NextByte = Byte - SieveSize;
+        Sieving.WheelIndex = WheelIndex;
+    }
+
+    WheelSievingPrime MakeWheelSievingPrime(const uint32_t Prime, const uint64_t SegmentByte)
+    {
+        // first multiple is Prime^2 or the first one inside the segment, with cofactor coprime to 30
+        const uint64_t FirstNumber = 30 * SegmentByte;
+        const uint64_t Cofactor = std::max<uint64_t>(Prime, FirstNumber / Prime + (FirstNumber % Prime != 0));
+        const uint32_t WheelIndex = FindWheelIndex(Cofactor % 30);
+        const uint64_t Multiple = Prime * (Cofactor / 30 * 30 + WheelOffsets[WheelIndex]);
+
+        WheelSievingPrime Result;
+        Result.Quotient = Prime / 30;
+        Result.ResidueIndex = FindWheelIndex(Prime % 30);
+        Result.WheelIndex = WheelIndex;
+        Result.NextByte = Multiple / 30 - SegmentByte;
+
+        return Result;
+    }
+
+    void CrossOffWheelSegment(uint8_t* Segment, const uint64_t SegmentSize, std::vector<WheelSievingPrime>& SievingPrimes)
+    {
+        for (WheelSievingPrime& Sieving : SievingPrimes)
+        {
+            switch (Sieving.ResidueIndex)
+            {
+                case 0: CrossOffWheelPrime<0>(Segment, SegmentSize, Sieving); break;
+                case 1: CrossOffWheelPrime<1>(Segment, SegmentSize, Sieving); break;
+                case 2: CrossOffWheelPrime<2>(Segment, SegmentSize, Sieving); break;
+                case 3: CrossOffWheelPrime<3>(Segment, SegmentSize, Sieving); break;
+                case 4: CrossOffWheelPrime<4>(Segment, SegmentSize, Sieving); break;
+                case 5: CrossOffWheelPrime<5>(Segment, SegmentSize, Sieving); break;
+                case 6: CrossOffWheelPrime<6>(Segment, SegmentSize, Sieving); break;
+                case 7: CrossOffWheelPrime<7>(Segment, SegmentSize, Sieving); break;
+                default: break;
+            }
+        }
+    }
+}
+
+void FindCompositesWheel(std::vector<uint64_t>& Result, const uint64_t NumbersToCheck, const uint64_t SegmentBytes)
+{
+    const uint64_t NumBytes = (NumbersToCheck + 29) / 30;
+    // segments have to start at word boundary
+    const uint64_t SegmentSize = std::max<uint64_t>(SegmentBytes / sizeof(uint64_t), 1) * sizeof(uint64_t);
+
+    Result.assign((NumBytes + 7) / 8, 0);
+    if (NumBytes == 0)
+    {
+        return;
+    }
+
+    uint8_t* Sieve = reinterpret_cast<uint8_t*>(Result.data());
+
+    // one is neither prime nor composite number
+    Sieve[0] |= 1;
+
+    std::vector<WheelSievingPrime> SievingPrimes;
+    for (const uint32_t Prime : FindBasePrimes(ISqrt(NumbersToCheck - 1)))
+    {
+        // 3 and 5 are already skipped by the wheel
+        if (Prime > 5)
+        {
+            SievingPrimes.push_back(MakeWheelSievingPrime(Prime, 0));
+        }
+    }
+
+    for (uint64_t SegmentByte = 0; SegmentByte < NumBytes; SegmentByte += SegmentSize)
+    {
+        CrossOffWheelSegment(Sieve + SegmentByte, std::min(SegmentSize, NumBytes - SegmentByte), SievingPrimes);
+    }
+
+    // hide numbers past the end, including padding of the last word
+    for (uint64_t Byte = NumbersToCheck / 30; Byte < Result.size() * sizeof(uint64_t); ++Byte)
+    {
+        for (uint32_t WheelIndex = 0; WheelIndex < 8; ++WheelIndex)
+        {
+            if (30 * Byte + WheelOffsets[WheelIndex] >= NumbersToCheck)
+            {
+                Sieve[Byte] |= 1 << WheelIndex;
+            }
+        }
+    }
+}
+
+PrimesSummary SummarizeWheel(const std::vector<uint64_t>& Table, const uint64_t NumbersToCheck)
+{
+    PrimesSummary Result;
+
+    // 2, 3 and 5 are not stored in the wheel
+    for (const uint64_t Prime : {2, 3, 5})
+    {
+        if (Prime < NumbersToCheck)
+        {
+            ++Result.Count;
+            Result.Sum += Prime;
+        }
+    }
+
+    for (uint64_t WordIndex = 0; WordIndex < Table.size(); ++WordIndex)
+    {
+        uint64_t Primes = ~Table[WordIndex];
+        Result.Count += std::popcount(Primes);
+
+        while (Primes != 0)
+        {
+            const uint32_t BitIndex = std::countr_zero(Primes);
+            const uint64_t Byte = WordIndex * sizeof(uint64_t) + BitIndex / 8;
+            Result.Sum += 30 * Byte + WheelOffsets[BitIndex % 8];
+            Primes &= Primes - 1;
+        }
+    }
+
+    return Result;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "SegmentedSieve.h"
+
+// Mod 30 wheel layout: byte i stands for the numbers 30 * i + {1, 7, 11, 13, 17, 19, 23, 29},
+// one bit each, set bit means "not a prime". Multiples of 2, 3 and 5 are not stored at all.
+// Bytes are packed into raw 64-bit words, so the table is read word at a time on little endian machines.
+
+constexpr uint32_t WheelOffsets[8] = {1, 7, 11, 13, 17, 19, 23, 29};
+
+struct WheelSievingPrime
+{
+    // Prime / 30
+    uint32_t Quotient;
+    // Index of Prime % 30 in WheelOffsets, selects unrolled crossing off loop
+    uint8_t ResidueIndex;
+    // Index of the next multiple's cofactor % 30 in WheelOffsets
+    uint8_t WheelIndex;
+    // Byte of the next multiple to cross off, relative to the start of the current segment
+    uint64_t NextByte;
+};
+
+// Sieves numbers below NumbersToCheck one SegmentBytes sized window at a time.
+// Bits standing for numbers >= NumbersToCheck are set, so the whole table can be reduced without masking.
+void FindCompositesWheel(std::vector<uint64_t>& Result, uint64_t NumbersToCheck, uint64_t SegmentBytes);
+
+// Counts and sums primes in a mod 30 wheel table, including 2, 3 and 5.
+PrimesSummary SummarizeWheel(const std::vector<uint64_t>& Table, uint64_t NumbersToCheck);
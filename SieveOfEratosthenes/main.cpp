@@ -1,15 +1,38 @@
+#include <algorithm>
 #include <iostream>
 #include <chrono>
 #include <bitset>
 #include <cmath>
+#include <filesystem>
+#include <string>
+#include <thread>
 
+#include "CacheTopology.h"
 #include "PerformanceCounter.h"
-#include "L1DataCacheSize.h"
+#include "CompileTimePrimes.h"
+#include "PrimeCounting.h"
+#include "PrimeGenerator.h"
+#include "PrimeTableFile.h"
+#include "SegmentedSieve.h"
+#include "SieveReduction.h"
+#include "WheelSieve.h"
 
 const static uint32_t NUMBERS_TO_CHECK = 70000000;
 // const uint32_t NUMBERS_TO_CHECK = 25;
 
-const static uint32_t L1_SIZE = get_l1d_cache_size() * 1024;
+// Segments of a few L1 sizes, at most half of L2 so base primes stay in L2 next to the segment.
+// Fallback for platforms where cache sizes couldn't be detected.
+uint64_t GetSegmentBytes()
+{
+    const uint64_t L1Size = CacheTopology::GetDataCacheSize(1);
+    if (L1Size == 0)
+    {
+        return 128 * 1024;
+    }
+
+    const uint64_t L2Size = CacheTopology::GetDataCacheSize(2);
+    return L2Size > 0 ? std::min(L1Size * 4, L2Size / 2) : L1Size * 4;
+}
 
 // template<uint32_t NumbersToCheck>
 void FindCompositesUsingErato(std::vector<bool>& Result, const uint32_t NumbersToCheck)
@@ -29,6 +52,451 @@ void FindCompositesUsingErato(std::vector<bool>& Result, const uint32_t NumbersT
     }
 }
 
+void TestSegmentedSieve()
+{
+    // Fallback for platforms where cache size couldn't be detected
+    const uint64_t L1Size = CacheTopology::GetDataCacheSize(1);
+    const uint64_t SmallestSegment = L1Size > 0 ? L1Size / 2 : 16 * 1024;
+    // From half of L1 to a typical L2 size and beyond
+    constexpr uint32_t NumSegmentSizes = 8;
+
+    std::printf("=======| Segmented sieve |=======\n");
+
+    PerformanceCounter PerfCounter;
+    std::vector<uint64_t> Result;
+    for (uint32_t SizeId = 0; SizeId < NumSegmentSizes; ++SizeId)
+    {
+        const uint64_t SegmentBytes = SmallestSegment << SizeId;
+
+        PerfCounter.Reset();
+        FindCompositesSegmented(Result, NUMBERS_TO_CHECK, SegmentBytes);
+        const double Time = PerfCounter.Elapsed();
+
+        const uint64_t PrimesSum = SummarizeOddTable(Result, 0, NUMBERS_TO_CHECK).Sum;
+        std::printf("Segment %6.1f KiB: %fms (correct: %s)\n", static_cast<float>(SegmentBytes) / 1024.f, Time,
+                    PrimesSum == 139601928199359lu ? "True" : "False");
+    }
+}
+
+void TestParallelSieve()
+{
+#if !NDEBUG
+    constexpr uint64_t RangesToCheck[] = {NUMBERS_TO_CHECK, 1000000000lu};
+#else
+    constexpr uint64_t RangesToCheck[] = {NUMBERS_TO_CHECK, 1000000000lu, 10000000000lu};
+#endif
+
+    const uint64_t SegmentBytes = GetSegmentBytes();
+    const uint32_t MaxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    std::printf("=======| Parallel sieve |=======\n");
+
+    PerformanceCounter PerfCounter;
+    for (const uint64_t NumbersToCheck : RangesToCheck)
+    {
+        std::printf("Numbers to check: %llu\n", NumbersToCheck);
+
+        // Store the table only when it fits comfortably in memory
+        std::vector<uint64_t> Table;
+        std::vector<uint64_t>* Result = NumbersToCheck == NUMBERS_TO_CHECK ? &Table : nullptr;
+
+        double SingleThreadTime = 0.;
+        for (uint32_t NumThreads = 1; ; NumThreads = std::min(NumThreads * 2, MaxThreads))
+        {
+            PerfCounter.Reset();
+            const PrimesSummary Summary = SieveParallel(Result, NumbersToCheck, NumThreads, SegmentBytes);
+            const double Time = PerfCounter.Elapsed();
+
+            if (NumThreads == 1)
+            {
+                SingleThreadTime = Time;
+            }
+
+            std::printf("%3u threads: %fms (speedup: %.2fx) primes: %llu sum: %llu\n", NumThreads, Time, SingleThreadTime / Time,
+                        Summary.Count, Summary.Sum);
+
+            if (NumThreads == MaxThreads)
+            {
+                break;
+            }
+        }
+
+        if (NumbersToCheck == NUMBERS_TO_CHECK)
+        {
+            std::printf("Correct: %s\n", SummarizeOddTable(Table, 0, NUMBERS_TO_CHECK).Sum == 139601928199359lu ? "True" : "False");
+        }
+    }
+}
+
+enum class ESieveLayout
+{
+    // one bit per odd number
+    OddBits,
+    // one bit per number coprime to 30, 8 bits per 30 numbers
+    Mod30Wheel,
+};
+
+const char* GetLayoutName(const ESieveLayout Layout)
+{
+    switch (Layout)
+    {
+        case ESieveLayout::OddBits: return "odd bits";
+        case ESieveLayout::Mod30Wheel: return "mod 30 wheel";
+    }
+
+    return "unknown";
+}
+
+void TestSieveLayouts()
+{
+    constexpr ESieveLayout Layouts[] = {ESieveLayout::OddBits, ESieveLayout::Mod30Wheel};
+    const uint64_t SegmentBytes = GetSegmentBytes();
+
+    std::printf("=======| Sieve layouts |=======\n");
+
+    PerformanceCounter PerfCounter;
+    std::vector<uint64_t> Result;
+    for (const ESieveLayout Layout : Layouts)
+    {
+        PerfCounter.Reset();
+        switch (Layout)
+        {
+            case ESieveLayout::OddBits:
+                FindCompositesSegmented(Result, NUMBERS_TO_CHECK, SegmentBytes);
+                break;
+            case ESieveLayout::Mod30Wheel:
+                FindCompositesWheel(Result, NUMBERS_TO_CHECK, SegmentBytes);
+                break;
+        }
+        const double Time = PerfCounter.Elapsed();
+
+        const uint64_t PrimesSum = Layout == ESieveLayout::OddBits
+            ? SummarizeOddTable(Result, 0, NUMBERS_TO_CHECK).Sum
+            : SummarizeWheel(Result, NUMBERS_TO_CHECK).Sum;
+
+        std::printf("%s: %fms, table: %f MiB, correct: %s\n", GetLayoutName(Layout), Time,
+                    static_cast<float>(Result.size() * sizeof(uint64_t)) / 1024.f / 1024.f,
+                    PrimesSum == 139601928199359lu ? "True" : "False");
+    }
+}
+
+void TestPrimeGenerator()
+{
+    struct PrimeWindow
+    {
+        uint64_t Low;
+        uint64_t High;
+    };
+
+#if !NDEBUG
+    constexpr PrimeWindow Windows[] = {{0, NUMBERS_TO_CHECK}, {1000000000000lu, 1000010000000lu}};
+#else
+    constexpr PrimeWindow Windows[] = {
+        {0, NUMBERS_TO_CHECK},
+        {1000000000000lu, 1000100000000lu},
+        {1000000000000000lu, 1000000100000000lu},
+        {1000000000000000000lu, 1000000000100000000lu},
+    };
+#endif
+
+    const uint64_t SegmentBytes = GetSegmentBytes();
+
+    std::printf("=======| Prime generator |=======\n");
+
+    PerformanceCounter PerfCounter;
+    for (const PrimeWindow& Window : Windows)
+    {
+        PerfCounter.Reset();
+
+        PrimesSummary Summary;
+        for (const uint64_t Prime : PrimeGenerator(Window.Low, Window.High, SegmentBytes))
+        {
+            ++Summary.Count;
+            Summary.Sum += Prime;
+        }
+
+        const double Time = PerfCounter.Elapsed();
+
+        std::printf("[%llu, %llu): %fms, primes: %llu, %f M primes/s\n", Window.Low, Window.High, Time,
+                    Summary.Count, static_cast<double>(Summary.Count) / Time * 1e-3);
+
+        if (Window.Low == 0 && Window.High == NUMBERS_TO_CHECK)
+        {
+            std::printf("Correct: %s\n", Summary.Sum == 139601928199359lu ? "True" : "False");
+        }
+    }
+}
+
+void TestReduction()
+{
+    constexpr uint32_t NumRepeats = 10;
+    const uint64_t SegmentBytes = GetSegmentBytes();
+
+    std::printf("=======| Reduction |=======\n");
+
+    std::vector<uint64_t> Table;
+    FindCompositesSegmented(Table, NUMBERS_TO_CHECK, SegmentBytes);
+    const uint64_t NumBits = NUMBERS_TO_CHECK / 2;
+
+    PerformanceCounter PerfCounter;
+
+    PerfCounter.Reset();
+    uint64_t BitSum = 0;
+    for (uint32_t RepeatId = 0; RepeatId < NumRepeats; ++RepeatId)
+    {
+        for (uint64_t BitIndex = 0; BitIndex < NumBits; ++BitIndex)
+        {
+            const bool bPrime = !(Table[BitIndex / 64] >> (BitIndex % 64) & 1);
+            BitSum += bPrime * (2 * BitIndex + 1);
+        }
+    }
+    std::printf("bit at a time: %fms\n", PerfCounter.Elapsed() / NumRepeats);
+
+    PerfCounter.Reset();
+    PrimesSummary Scalar;
+    for (uint32_t RepeatId = 0; RepeatId < NumRepeats; ++RepeatId)
+    {
+        Scalar = SummarizeSegment(Table.data(), NumBits, 0);
+    }
+    std::printf("popcount + countr_zero: %fms, primes: %llu\n", PerfCounter.Elapsed() / NumRepeats, Scalar.Count + 1);
+
+    PerfCounter.Reset();
+    PrimesSummary SSE;
+    for (uint32_t RepeatId = 0; RepeatId < NumRepeats; ++RepeatId)
+    {
+        SSE = SummarizeSegmentSSE(Table.data(), NumBits, 0);
+    }
+    std::printf("SSE: %fms, primes: %llu\n", PerfCounter.Elapsed() / NumRepeats, SSE.Count + 1);
+
+    // two isn't stored in the table
+    const bool bCorrect = BitSum / NumRepeats + 2 == 139601928199359lu && Scalar.Sum + 2 == 139601928199359lu && SSE.Sum + 2 == 139601928199359lu;
+    std::printf("Correct: %s\n", bCorrect ? "True" : "False");
+
+    for (const uint64_t Bound : {1000lu, 1000000lu, 10000000lu, static_cast<uint64_t>(NUMBERS_TO_CHECK)})
+    {
+        PerfCounter.Reset();
+        const PrimesSummary Summary = SummarizeOddTable(Table, 0, Bound);
+        std::printf("pi(%llu) = %llu, sum: %llu, %fms\n", Bound, Summary.Count, Summary.Sum, PerfCounter.Elapsed());
+    }
+}
+
+void TestPrimeTableCache()
+{
+    struct CacheFile
+    {
+        const char* Name;
+        EPrimeTableEncoding Encoding;
+    };
+
+    constexpr CacheFile Files[] = {
+        {"prime_table_bits.bin", EPrimeTableEncoding::OddBits},
+        {"prime_table_deltas.bin", EPrimeTableEncoding::DeltaVarint},
+    };
+
+    const uint64_t SegmentBytes = GetSegmentBytes();
+
+    std::printf("=======| Prime table cache |=======\n");
+
+    PerformanceCounter PerfCounter;
+    for (const CacheFile& File : Files)
+    {
+        // built in the temp directory and removed afterwards, the files are several MiB
+        const std::string Path = (std::filesystem::temp_directory_path() / File.Name).string();
+        std::printf("%s\n", File.Name);
+        std::filesystem::remove(Path);
+
+        MappedPrimeTable Table;
+
+        // build half of the table, map it, then extend it to the full range and map it again
+        PerfCounter.Reset();
+        LoadOrBuildPrimeTable(Table, Path.c_str(), NUMBERS_TO_CHECK / 2, File.Encoding, SegmentBytes);
+        std::printf("build %u: %fms\n", NUMBERS_TO_CHECK / 2, PerfCounter.Elapsed());
+
+        Table.Close();
+        PerfCounter.Reset();
+        LoadOrBuildPrimeTable(Table, Path.c_str(), NUMBERS_TO_CHECK / 2, File.Encoding, SegmentBytes);
+        std::printf("map %u: %fms\n", NUMBERS_TO_CHECK / 2, PerfCounter.Elapsed());
+
+        PerfCounter.Reset();
+        LoadOrBuildPrimeTable(Table, Path.c_str(), NUMBERS_TO_CHECK, File.Encoding, SegmentBytes);
+        std::printf("extend to %u: %fms\n", NUMBERS_TO_CHECK, PerfCounter.Elapsed());
+
+        Table.Close();
+        PerfCounter.Reset();
+        const bool bLoaded = LoadOrBuildPrimeTable(Table, Path.c_str(), NUMBERS_TO_CHECK, File.Encoding, SegmentBytes);
+        std::printf("map %u: %fms\n", NUMBERS_TO_CHECK, PerfCounter.Elapsed());
+
+        if (!bLoaded)
+        {
+            std::printf("Failed to load %s\n", Path.c_str());
+            std::filesystem::remove(Path);
+            continue;
+        }
+
+        // reads go straight to the mapped file
+        PerfCounter.Reset();
+        uint64_t PrimesSum = 0;
+        if (File.Encoding == EPrimeTableEncoding::OddBits)
+        {
+            PrimesSum = SummarizeOddTable(Table.GetWords(), 0, NUMBERS_TO_CHECK).Sum;
+        }
+        else
+        {
+            DeltaPrimeReader Reader(Table.GetDeltas(), Table.GetHeader().Bound);
+            for (uint64_t Prime; Reader.Next(Prime);)
+            {
+                PrimesSum += Prime;
+            }
+        }
+        std::printf("read: %fms\n", PerfCounter.Elapsed());
+
+        std::printf("file: %f MiB, correct: %s\n",
+                    static_cast<float>(sizeof(PrimeTableHeader) + Table.GetHeader().PayloadBytes) / 1024.f / 1024.f,
+                    PrimesSum == 139601928199359lu && Table.GetHeader().PrimesSum == 139601928199359lu ? "True" : "False");
+
+        Table.Close();
+        std::filesystem::remove(Path);
+    }
+}
+
+void TestCompileTimeTables()
+{
+    constexpr uint32_t NumRepeats = 100;
+    constexpr uint32_t SmallBound = 65536;
+    const uint64_t SegmentBytes = GetSegmentBytes();
+
+    std::printf("=======| Compile time tables |=======\n");
+
+    PerformanceCounter PerfCounter;
+
+    PerfCounter.Reset();
+    uint64_t NumBasePrimes = 0;
+    for (uint32_t RepeatId = 0; RepeatId < NumRepeats; ++RepeatId)
+    {
+        NumBasePrimes += SieveBasePrimes(SmallBound - 1).size();
+    }
+    std::printf("base primes below %u, runtime sieve: %fms\n", SmallBound, PerfCounter.Elapsed() / NumRepeats);
+
+    PerfCounter.Reset();
+    for (uint32_t RepeatId = 0; RepeatId < NumRepeats; ++RepeatId)
+    {
+        NumBasePrimes += FindBasePrimes(SmallBound - 1).size();
+    }
+    std::printf("base primes below %u, compile time table: %fms\n", SmallBound, PerfCounter.Elapsed() / NumRepeats);
+    std::printf("Correct: %s\n", NumBasePrimes == 2 * NumRepeats * CompileTimeBasePrimes.size() ? "True" : "False");
+
+    // startup and sieve together, base primes are the only difference
+    std::vector<uint64_t> Result;
+    for (const uint64_t NumbersToCheck : {10000lu, 1000000lu, static_cast<uint64_t>(NUMBERS_TO_CHECK)})
+    {
+        const uint32_t Repeats = NumbersToCheck == NUMBERS_TO_CHECK ? 1 : NumRepeats;
+
+        PerfCounter.Reset();
+        for (uint32_t RepeatId = 0; RepeatId < Repeats; ++RepeatId)
+        {
+            FindCompositesSegmented(Result, NumbersToCheck, SegmentBytes, SieveBasePrimes(ISqrt(NumbersToCheck - 1)));
+        }
+        const double RuntimeTime = PerfCounter.Elapsed() / Repeats;
+
+        PerfCounter.Reset();
+        for (uint32_t RepeatId = 0; RepeatId < Repeats; ++RepeatId)
+        {
+            FindCompositesSegmented(Result, NumbersToCheck, SegmentBytes);
+        }
+        const double CompileTime = PerfCounter.Elapsed() / Repeats;
+
+        std::printf("sieve %llu: runtime base primes %fms, compile time base primes %fms\n", NumbersToCheck, RuntimeTime, CompileTime);
+    }
+
+    // tiny queries don't have to sieve anything
+    PerfCounter.Reset();
+    uint64_t RuntimeCount = 0;
+    for (uint32_t RepeatId = 0; RepeatId < NumRepeats; ++RepeatId)
+    {
+        FindCompositesSegmented(Result, SmallBound, SegmentBytes);
+        RuntimeCount += SummarizeOddTable(Result, 0, SmallBound - RepeatId).Count;
+    }
+    std::printf("pi(x) below %u, runtime sieve: %fms\n", SmallBound, PerfCounter.Elapsed() / NumRepeats);
+
+    PerfCounter.Reset();
+    uint64_t CompileTimeCount = 0;
+    for (uint32_t RepeatId = 0; RepeatId < NumRepeats; ++RepeatId)
+    {
+        CompileTimeCount += SmallPrimeTable<SmallBound>::CountPrimes(SmallBound - RepeatId);
+    }
+    std::printf("pi(x) below %u, compile time table: %fms\n", SmallBound, PerfCounter.Elapsed() / NumRepeats);
+    std::printf("Correct: %s\n", RuntimeCount == CompileTimeCount ? "True" : "False");
+}
+
+void TestPreSieve()
+{
+    constexpr uint32_t NumRepeats = 10;
+    const uint64_t SegmentBytes = GetSegmentBytes();
+    const uint64_t SegmentBits = SegmentBytes * 8;
+    const uint64_t NumBits = NUMBERS_TO_CHECK / 2;
+
+    std::printf("=======| Pre-sieve |=======\n");
+
+    PerformanceCounter PerfCounter;
+    std::vector<uint64_t> Result((NumBits + 63) / 64);
+
+    // the pattern is built on first use
+    PreSieveSegment(Result.data(), 64, 0);
+
+    PerfCounter.Reset();
+    for (uint32_t RepeatId = 0; RepeatId < NumRepeats; ++RepeatId)
+    {
+        for (uint64_t SegmentStart = 0; SegmentStart < NumBits; SegmentStart += SegmentBits)
+        {
+            PreSieveSegment(&Result[SegmentStart / 64], std::min(SegmentBits, NumBits - SegmentStart), SegmentStart);
+        }
+    }
+    std::printf("pre-sieve step only (%s): %fms\n", "3, 5, 7, 11, 13", PerfCounter.Elapsed() / NumRepeats);
+
+    for (const bool bPreSieve : {false, true})
+    {
+        PerfCounter.Reset();
+        for (uint32_t RepeatId = 0; RepeatId < NumRepeats; ++RepeatId)
+        {
+            FindCompositesSegmented(Result, NUMBERS_TO_CHECK, SegmentBytes, {}, bPreSieve);
+        }
+        const double Time = PerfCounter.Elapsed() / NumRepeats;
+
+        std::printf("sieve %s pre-sieve: %fms, correct: %s\n", bPreSieve ? "with" : "without", Time,
+                    SummarizeOddTable(Result, 0, NUMBERS_TO_CHECK).Sum == 139601928199359lu ? "True" : "False");
+    }
+}
+
+void TestPrimeCounting()
+{
+#if !NDEBUG
+    constexpr uint64_t Bounds[] = {NUMBERS_TO_CHECK, 1000000000lu, 10000000000lu, 100000000000lu};
+#else
+    constexpr uint64_t Bounds[] = {NUMBERS_TO_CHECK, 1000000000lu, 10000000000lu, 100000000000lu, 1000000000000lu, 10000000000000lu};
+#endif
+
+    std::printf("=======| Prime counting |=======\n");
+
+    PerformanceCounter PerfCounter;
+    for (const uint64_t Bound : Bounds)
+    {
+        PerfCounter.Reset();
+        const uint64_t Count = CountPrimes(Bound);
+        const double CountTime = PerfCounter.Elapsed();
+
+        PerfCounter.Reset();
+        const PrimeSum Sum = SumPrimes(Bound);
+        const double SumTime = PerfCounter.Elapsed();
+
+        std::printf("%llu: count %fms, sum %fms, primes: %llu sum: %s\n", Bound, CountTime, SumTime, Count, ToString(Sum).c_str());
+
+        if (Bound == NUMBERS_TO_CHECK)
+        {
+            std::printf("Correct: %s\n", Count == 4118064 && Sum == 139601928199359lu ? "True" : "False");
+        }
+    }
+}
+
 int main()
 {
     PerformanceCounter PerfCounter;
@@ -44,19 +512,47 @@ int main()
     // we are skipping even nubers so we need to add 2 to whole sum
     uint64_t PrimesSum = 2;
     uint64_t PrimesNum = 1;
-    for (size_t BitIndex = 1; BitIndex <= Result.size(); ++BitIndex)
+    for (size_t BitIndex = 1; BitIndex < Result.size(); ++BitIndex)
     {
-        PrimesSum += !Result[BitIndex] * (2 * BitIndex + 1);
-        ++PrimesNum;
+        const bool bPrime = !Result[BitIndex];
+        PrimesSum += bPrime * (2 * BitIndex + 1);
+        PrimesNum += bPrime;
     }
 
-    std::printf("L1 Size: %f KiB\n", static_cast<float>(L1_SIZE) / 1024.f);
+    CacheTopology::Print();
 
     std::printf("Num primes in set: %llu\n", PrimesNum);
     std::printf("Size of primes in set: %f MiB\n", static_cast<float>(PrimesNum) * sizeof(uint64_t) / 1024.f / 1024.f);
-    std::printf("Size of bitset: %lu MiB\n", sizeof(Result) / 1024.f / 1024.f);
+    std::printf("Size of bitset: %f MiB\n", static_cast<float>(Result.size()) / 8.f / 1024.f / 1024.f);
     std::printf("Checksum: %llu (expected: 139601928199359)\n", PrimesSum);
     std::printf("Correct: %s\n", PrimesSum == 139601928199359lu ? "True" : "False");
+    std::printf("\n");
+
+    TestSegmentedSieve();
+    std::printf("\n");
+
+    TestParallelSieve();
+    std::printf("\n");
+
+    TestSieveLayouts();
+    std::printf("\n");
+
+    TestPrimeGenerator();
+    std::printf("\n");
+
+    TestReduction();
+    std::printf("\n");
+
+    TestPrimeTableCache();
+    std::printf("\n");
+
+    TestCompileTimeTables();
+    std::printf("\n");
+
+    TestPreSieve();
+    std::printf("\n");
+
+    TestPrimeCounting();
 
     return 0;
 }